@@ -30,14 +30,17 @@
 #include <bitcoin/blockchain/organizers/header_organizer.hpp>
 #include <bitcoin/blockchain/organizers/transaction_organizer.hpp>
 #include <bitcoin/blockchain/pools/anchor_converter.hpp>
+#include <bitcoin/blockchain/pools/block_cache.hpp>
 #include <bitcoin/blockchain/pools/child_closure_calculator.hpp>
 #include <bitcoin/blockchain/pools/conflicting_spend_remover.hpp>
 #include <bitcoin/blockchain/pools/header_branch.hpp>
+#include <bitcoin/blockchain/pools/header_buffer.hpp>
 #include <bitcoin/blockchain/pools/header_entry.hpp>
 #include <bitcoin/blockchain/pools/header_pool.hpp>
 #include <bitcoin/blockchain/pools/parent_closure_calculator.hpp>
 #include <bitcoin/blockchain/pools/priority_calculator.hpp>
 #include <bitcoin/blockchain/pools/stack_evaluator.hpp>
+#include <bitcoin/blockchain/pools/transaction_cache.hpp>
 #include <bitcoin/blockchain/pools/transaction_entry.hpp>
 #include <bitcoin/blockchain/pools/transaction_order_calculator.hpp>
 #include <bitcoin/blockchain/pools/transaction_pool.hpp>
@@ -47,6 +50,14 @@
 #include <bitcoin/blockchain/populate/populate_chain_state.hpp>
 #include <bitcoin/blockchain/populate/populate_header.hpp>
 #include <bitcoin/blockchain/populate/populate_transaction.hpp>
+#include <bitcoin/blockchain/utility/bloom_filter.hpp>
+#include <bitcoin/blockchain/utility/chain_columns.hpp>
+#include <bitcoin/blockchain/utility/hash_filter.hpp>
+#include <bitcoin/blockchain/utility/partial_merkle_tree.hpp>
+#include <bitcoin/blockchain/utility/query_executor.hpp>
+#include <bitcoin/blockchain/utility/spend_index.hpp>
+#include <bitcoin/blockchain/utility/stealth_index.hpp>
+#include <bitcoin/blockchain/utility/write_batch.hpp>
 #include <bitcoin/blockchain/validate/validate_block.hpp>
 #include <bitcoin/blockchain/validate/validate_header.hpp>
 #include <bitcoin/blockchain/validate/validate_input.hpp>
@@ -24,6 +24,10 @@
 #include <cstdint>
 #include <ctime>
 #include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <utility>
 #include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database.hpp>
@@ -33,11 +37,21 @@
 #include <bitcoin/blockchain/organizers/block_organizer.hpp>
 #include <bitcoin/blockchain/organizers/header_organizer.hpp>
 #include <bitcoin/blockchain/organizers/transaction_organizer.hpp>
+#include <bitcoin/blockchain/pools/block_cache.hpp>
 #include <bitcoin/blockchain/pools/header_branch.hpp>
+#include <bitcoin/blockchain/pools/header_buffer.hpp>
 #include <bitcoin/blockchain/pools/header_pool.hpp>
+#include <bitcoin/blockchain/pools/transaction_cache.hpp>
 #include <bitcoin/blockchain/pools/transaction_pool.hpp>
 #include <bitcoin/blockchain/populate/populate_chain_state.hpp>
 #include <bitcoin/blockchain/settings.hpp>
+#include <bitcoin/blockchain/utility/bloom_filter.hpp>
+#include <bitcoin/blockchain/utility/chain_columns.hpp>
+#include <bitcoin/blockchain/utility/hash_filter.hpp>
+#include <bitcoin/blockchain/utility/query_executor.hpp>
+#include <bitcoin/blockchain/utility/spend_index.hpp>
+#include <bitcoin/blockchain/utility/stealth_index.hpp>
+#include <bitcoin/blockchain/utility/write_batch.hpp>
 
 namespace libbitcoin {
 namespace blockchain {
@@ -121,6 +135,16 @@ public:
     /// Push a validatable block identifier onto the download subscriber. 
     void prime_validation(const hash_digest& hash, size_t height) const;
 
+    /// Get the empty (downloadable) and the populated unvalidated candidate
+    /// blocks in the height window, from the in-memory candidate index.
+    void get_download_schedule(config::checkpoint::list& out_downloadable,
+        config::checkpoint::list& out_validatable, size_t from_height,
+        size_t count) const;
+
+    /// Get heights of missing blocks below the highest awaiting validation.
+    void get_download_gaps(chain::block::indexes& out_heights,
+        size_t limit) const;
+
     /// Populate metadata of the given block header.
     void populate_header(const chain::header& header) const;
 
@@ -230,6 +254,7 @@ public:
     bool start();
 
     /// Signal pool work stop, speeds shutdown with multiple threads.
+    /// Accepted queries complete (invoking their handlers) before return.
     bool stop();
 
     /// Unmaps all memory and frees the database file handles.
@@ -247,6 +272,20 @@ public:
     void fetch_block(const hash_digest& hash, bool witness,
         block_fetch_handler handler) const;
 
+    /// fetch blocks of the confirmed chain in height order, read ahead.
+    void fetch_blocks(size_t from_height, size_t to_height, bool witness,
+        block_stream_handler handler) const;
+
+    /// fetch the wire serialization of a block by height.
+    /// No block message is constructed, but transactions are deserialized,
+    /// as the store does not hold them in wire format.
+    void fetch_block_data(size_t height, bool witness,
+        block_data_fetch_handler handler) const;
+
+    /// fetch the wire serialization of a block by hash (as above).
+    void fetch_block_data(const hash_digest& hash, bool witness,
+        block_data_fetch_handler handler) const;
+
     /// fetch block header by height.
     void fetch_block_header(size_t height,
         block_header_fetch_handler handler) const;
@@ -263,12 +302,20 @@ public:
     void fetch_merkle_block(const hash_digest& hash,
         merkle_block_fetch_handler handler) const;
 
-    /// fetch compact block by block height.
-    void fetch_compact_block(size_t height,
+    /// fetch a merkle block by height, filtered by and updating the filter.
+    void fetch_merkle_block(size_t height, bloom_filter::ptr filter,
+        filtered_block_fetch_handler handler) const;
+
+    /// fetch a merkle block by hash, filtered by and updating the filter.
+    void fetch_merkle_block(const hash_digest& hash, bloom_filter::ptr filter,
+        filtered_block_fetch_handler handler) const;
+
+    /// fetch compact block of the BIP152 version (1 or 2) by block height.
+    void fetch_compact_block(size_t height, uint64_t version,
         compact_block_fetch_handler handler) const;
 
-    /// fetch compact block by block hash.
-    void fetch_compact_block(const hash_digest& hash,
+    /// fetch compact block of the BIP152 version (1 or 2) by block hash.
+    void fetch_compact_block(const hash_digest& hash, uint64_t version,
         compact_block_fetch_handler handler) const;
 
     /// fetch height of block by hash.
@@ -282,6 +329,10 @@ public:
     void fetch_transaction(const hash_digest& hash, bool require_confirmed,
         bool witness, transaction_fetch_handler handler) const;
 
+    /// fetch transactions by hash, in request order (null if not found).
+    void fetch_transactions(const hash_list& hashes, bool require_confirmed,
+        bool witness, transactions_fetch_handler handler) const;
+
     /// fetch position and height within block of transaction by hash.
     void fetch_transaction_position(const hash_digest& hash,
         bool require_confirmed, transaction_index_fetch_handler handler) const;
@@ -296,6 +347,11 @@ public:
         const hash_digest& threshold, size_t limit,
         locator_block_headers_fetch_handler handler) const;
 
+    /// fetch the headers message payload indicated by the block locator.
+    void fetch_locator_block_headers_data(get_headers_const_ptr locator,
+        const hash_digest& threshold, size_t limit,
+        locator_block_headers_data_fetch_handler handler) const;
+
     /////// fetch an inventory locator relative to the current top and threshold.
     ////void fetch_block_locator(const chain::block::indexes& heights,
     ////    block_locator_fetch_handler handler) const;
@@ -311,10 +367,26 @@ public:
     void fetch_spend(const chain::output_point& outpoint,
         spend_fetch_handler handler) const;
 
+    /// fetch the inpoints (spenders) of outpoints, null if not spent.
+    void fetch_spends(const chain::output_point::list& outpoints,
+        spends_fetch_handler handler) const;
+
     /// fetch outputs, values and spends for an address_hash.
     void fetch_history(const short_hash& address_hash, size_t limit,
         size_t from_height, history_fetch_handler handler) const;
 
+    /// fetch outputs, values and spends for each address_hash, in order.
+    void fetch_history(const short_hash_list& address_hashes, size_t limit,
+        size_t from_height, history_list_fetch_handler handler) const;
+
+    /// fetch a page of history for an address_hash, following the cursor.
+    /// The first cursor is zero, each next is returned with the prior page.
+    /// Pages end on tx boundaries, and the cursor is stable as rows are added.
+    /// The handler returns the next cursor, or zero if the history is complete.
+    void fetch_history_page(const short_hash& address_hash, size_t cursor,
+        size_t page_size, size_t from_height,
+        history_page_fetch_handler handler) const;
+
     /// fetch stealth results.
     void fetch_stealth(const binary& filter, size_t from_height,
         stealth_fetch_handler handler) const;
@@ -363,6 +435,9 @@ public:
     /// Organize a header into the candidate chain and organize accordingly.
     void organize(header_const_ptr header, result_handler handler);
 
+    /// Organize a linked run of headers into the candidate chain at once.
+    void organize(headers_const_ptr headers, result_handler handler);
+
     /// Store a transaction to the pool.
     void organize(transaction_const_ptr tx, result_handler handler);
 
@@ -395,6 +470,12 @@ private:
     bool set_top_candidate_state();
     bool set_top_valid_candidate_state();
     bool set_next_confirmed_state();
+    bool prime_candidates() const;
+    code begin_write();
+    code commit_write(size_t blocks, size_t bytes);
+    code end_write();
+    code abort_write(const code& ec);
+    void handle_flush_timer(const code& ec);
 
     void set_fork_point(const config::checkpoint& fork);
     void set_candidate_work(const uint256_t& work_above_fork);
@@ -403,13 +484,119 @@ private:
     void set_top_valid_candidate_state(chain::chain_state::ptr top);
     void set_next_confirmed_state(chain::chain_state::ptr top);
 
+    // Columns.
+    chain_columns& columns(bool candidate);
+    const chain_columns& columns(bool candidate) const;
+    bool index_columns(size_t from_height, bool candidate);
+    void index_states(size_t from_height, size_t to_height, bool candidate);
+    void index_state(const hash_digest& block_hash);
+    bool get_height(size_t& out_height, const hash_digest& block_hash) const;
+    void cache_transactions(size_t fork_height,
+        block_const_ptr_list_const_ptr incoming,
+        block_const_ptr_list_const_ptr outgoing);
+
+    // Spends.
+    bool open_spends();
+    bool populate_spends(const chain::block& block, size_t height,
+        size_t top);
+    void index_spends(const chain::block& block, size_t height);
+    bool index_spends(size_t fork_height,
+        block_const_ptr_list_const_ptr incoming,
+        block_const_ptr_list_const_ptr outgoing);
+    bool get_spender(chain::input_point& out_spender,
+        const chain::output_point& outpoint) const;
+
+    // Query classes, each limited independently by the query executor.
+    enum query_class : size_t
+    {
+        block_query,
+        transaction_query,
+        locator_query,
+        server_query,
+        query_classes
+    };
+
+    static query_executor::limits::list query_limits(
+        const blockchain::settings& settings);
+
+    // Parallel reader state, shared with priority threads.
+    struct transaction_reader;
+    typedef std::shared_ptr<transaction_reader> transaction_reader_ptr;
+
+    // Read-ahead stream state, shared with query threads.
+    struct block_stream;
+    typedef std::shared_ptr<block_stream> block_stream_ptr;
+
     // Utilities.
     void index_block(block_const_ptr block);
+    void populate_indexes();
+    bool populate_filter();
+    void index_filter(const chain::block& block);
+    bool open_stealth();
+    bool populate_stealth(const chain::block& block, size_t height,
+        size_t top);
+    void index_stealth(const chain::block& block, size_t height);
+    bool index_stealth(size_t fork_height,
+        block_const_ptr_list_const_ptr incoming);
     void index_transaction(transaction_const_ptr tx);
     bool get_transactions(chain::transaction::list& out_transactions,
         const database::block_result& result, bool witness) const;
+    bool get_transactions(chain::transaction::list& out_transactions,
+        std::vector<file_offset>&& offsets, bool witness) const;
+    void read_transactions(transaction_reader_ptr reader) const;
+    code get_block(block_const_ptr& out_block, size_t height,
+        bool witness) const;
+    code get_block(block_const_ptr& out_block, size_t& out_height,
+        const hash_digest& hash, bool witness) const;
+    compact_block_ptr get_compact_block(block_const_ptr block,
+        uint64_t version) const;
+    static merkle_block_ptr filter_block(
+        transaction_const_ptr_list& out_matched, const chain::block& block,
+        bloom_filter& filter);
+    void submit_stream(block_stream_ptr stream, size_t height) const;
+    void deliver_stream(block_stream_ptr stream, size_t height, code ec,
+        block_const_ptr block) const;
     bool get_transaction_hashes(hash_list& out_hashes,
         const database::block_result& result) const;
+    bool get_block_data(data_chunk& out_data,
+        const database::block_result& result, bool witness) const;
+    size_t begin_confirmed_read() const;
+    bool end_confirmed_read(size_t epoch) const;
+    void begin_confirmed_write();
+    void end_confirmed_write();
+    typedef std::vector<chain::payment_record*> payment_pointers;
+    typedef std::vector<chain::payment_record::list> payment_lists;
+    typedef std::shared_ptr<payment_lists> payment_lists_ptr;
+    typedef std::shared_ptr<const short_hash_list> short_hash_list_ptr;
+
+    void get_payments(chain::payment_record::list& out_payments,
+        const short_hash& address_hash, size_t limit,
+        size_t from_height) const;
+    void set_payment_links(payment_pointers& payments) const;
+    static bool trim_payments(chain::payment_record::list& payments,
+        size_t from_height);
+    void scan_histories(short_hash_list_ptr address_hashes, size_t limit,
+        size_t from_height, size_t bucket, size_t buckets,
+        payment_lists_ptr histories, result_handler handler) const;
+    void handle_histories(const code& ec, payment_lists_ptr histories,
+        size_t from_height, history_list_fetch_handler handler) const;
+    size_t get_history(chain::payment_record::list& out_payments,
+        const short_hash& address_hash, size_t cursor, size_t limit,
+        size_t from_height, bool resumable) const;
+
+    // Open history pages, keyed by address and cursor.
+    struct history_cursor;
+    typedef std::shared_ptr<history_cursor> history_cursor_ptr;
+    typedef std::map<std::pair<short_hash, size_t>, history_cursor_ptr>
+        history_cursors;
+
+    history_cursor_ptr take_cursor(const short_hash& address_hash,
+        size_t cursor) const;
+    void put_cursor(const short_hash& address_hash, size_t cursor,
+        history_cursor_ptr history) const;
+    void get_locator_range(size_t& out_begin, size_t& out_end,
+        const hash_list& start_hashes, const hash_digest& stop_hash,
+        const hash_digest& threshold, size_t limit) const;
 
     // This is protected by mutex.
     database::data_base database_;
@@ -417,11 +604,10 @@ private:
     // These are thread safe.
     std::atomic<bool> stopped_;
 
+    std::atomic<size_t> confirmed_epoch_;
     bc::atomic<config::checkpoint> fork_point_;
     bc::atomic<uint256_t> candidate_work_;
     bc::atomic<uint256_t> confirmed_work_;
-    bc::atomic<block_const_ptr> last_block_;
-    bc::atomic<transaction_const_ptr> last_transaction_;
     bc::atomic<chain::chain_state::ptr> top_candidate_state_;
     bc::atomic<chain::chain_state::ptr> top_valid_candidate_state_;
     bc::atomic<chain::chain_state::ptr> next_confirmed_state_;
@@ -431,14 +617,48 @@ private:
     const populate_chain_state chain_state_populator_;
     const bool index_addresses_;
 
+    // This groups store writes for flushing, if the store does not flush
+    // each write. The store flush lock is set only while a group is open.
+    write_batch write_batch_;
+    deadline::ptr flush_timer_;
+
     mutable prioritized_mutex validation_mutex_;
+    mutable history_cursors history_cursors_;
+    mutable upgrade_mutex history_mutex_;
     mutable threadpool priority_pool_;
     mutable dispatcher priority_;
     mutable dispatcher dispatch_;
+    mutable threadpool query_pool_;
+    mutable query_executor query_executor_;
 
     header_pool header_pool_;
     transaction_pool transaction_pool_;
 
+    // These mirror the store header indexes, written under validation_mutex_.
+    chain_columns candidate_columns_;
+    chain_columns confirmed_columns_;
+    header_buffer confirmed_headers_;
+
+    // This holds valid blocks, shared by validation, reorganization, queries.
+    mutable block_cache block_cache_;
+    transaction_cache transaction_cache_;
+
+    // This generates compact block nonces, seeded once (guarded by mutex).
+    mutable std::mt19937_64 nonce_generator_;
+    mutable upgrade_mutex nonce_mutex_;
+
+    // This holds the hashes of stored transactions, for inventory. A miss is
+    // definitive once the start walk has added the transactions of the store.
+    hash_filter transaction_filter_;
+    std::atomic<bool> transaction_filter_primed_;
+
+    // This persists the confirmed spends, written under validation_mutex_.
+    spend_index spend_index_;
+
+    // This persists the confirmed stealth outputs, written under
+    // validation_mutex_ (populated from its committed top after start).
+    stealth_index stealth_index_;
+
     block_organizer block_organizer_;
     header_organizer header_organizer_;
     transaction_organizer transaction_organizer_;
@@ -96,6 +96,17 @@ public:
     virtual void prime_validation(const hash_digest& hash,
         size_t height) const = 0;
 
+    /// Get the empty (downloadable) and the populated unvalidated candidate
+    /// blocks in the height window, from the in-memory candidate index.
+    virtual void get_download_schedule(
+        config::checkpoint::list& out_downloadable,
+        config::checkpoint::list& out_validatable, size_t from_height,
+        size_t count) const = 0;
+
+    /// Get heights of missing blocks below the highest awaiting validation.
+    virtual void get_download_gaps(chain::block::indexes& out_heights,
+        size_t limit) const = 0;
+
     /// Populate metadata of the given block header.
     virtual void populate_header(const chain::header& header) const = 0;
 
@@ -26,6 +26,7 @@
 #include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/blockchain/define.hpp>
+#include <bitcoin/blockchain/utility/bloom_filter.hpp>
 
 namespace libbitcoin {
 namespace blockchain {
@@ -37,35 +38,51 @@ class BCB_API safe_chain
 {
 public:
     typedef handle0 result_handler;
+    typedef std::shared_ptr<const data_chunk> data_chunk_const_ptr;
 
     /// Object fetch handlers.
     typedef handle1<size_t> last_height_fetch_handler;
     typedef handle1<size_t> block_height_fetch_handler;
     typedef handle1<chain::output> output_fetch_handler;
     typedef handle1<chain::input_point> spend_fetch_handler;
+    typedef handle1<chain::input_point::list> spends_fetch_handler;
     typedef handle1<chain::payment_record::list> history_fetch_handler;
+    typedef handle1<std::vector<chain::payment_record::list>>
+        history_list_fetch_handler;
     typedef handle1<chain::stealth_record::list> stealth_fetch_handler;
     typedef handle2<size_t, size_t> transaction_index_fetch_handler;
 
     // Smart pointer parameters must not be passed by reference.
     typedef std::function<void(const code&, block_const_ptr, size_t)>
         block_fetch_handler;
+    typedef std::function<bool(const code&, block_const_ptr, size_t)>
+        block_stream_handler;
+    typedef std::function<void(const code&, data_chunk_const_ptr, size_t)>
+        block_data_fetch_handler;
     typedef std::function<void(const code&, merkle_block_ptr, size_t)>
         merkle_block_fetch_handler;
+    typedef std::function<void(const code&, merkle_block_ptr,
+        transaction_const_ptr_list, size_t)> filtered_block_fetch_handler;
     typedef std::function<void(const code&, compact_block_ptr, size_t)>
         compact_block_fetch_handler;
     typedef std::function<void(const code&, header_ptr, size_t)>
         block_header_fetch_handler;
     typedef std::function<void(const code&, transaction_const_ptr, size_t,
         size_t)> transaction_fetch_handler;
+    typedef std::function<void(const code&, transaction_const_ptr_list)>
+        transactions_fetch_handler;
     typedef std::function<void(const code&, headers_ptr)>
         locator_block_headers_fetch_handler;
+    typedef std::function<void(const code&, data_chunk_const_ptr)>
+        locator_block_headers_data_fetch_handler;
     typedef std::function<void(const code&, get_blocks_ptr)>
         block_locator_fetch_handler;
     typedef std::function<void(const code&, get_headers_ptr)>
         header_locator_fetch_handler;
     typedef std::function<void(const code&, inventory_ptr)>
         inventory_fetch_handler;
+    typedef std::function<void(const code&, chain::payment_record::list,
+        size_t)> history_page_fetch_handler;
 
     /// Subscription handlers.
     typedef std::function<bool(code, size_t, header_const_ptr_list_const_ptr,
@@ -91,6 +108,15 @@ public:
     virtual void fetch_block(const hash_digest& hash, bool witness,
         block_fetch_handler handler) const = 0;
 
+    virtual void fetch_blocks(size_t from_height, size_t to_height,
+        bool witness, block_stream_handler handler) const = 0;
+
+    virtual void fetch_block_data(size_t height, bool witness,
+        block_data_fetch_handler handler) const = 0;
+
+    virtual void fetch_block_data(const hash_digest& hash, bool witness,
+        block_data_fetch_handler handler) const = 0;
+
     virtual void fetch_block_header(size_t height,
         block_header_fetch_handler handler) const = 0;
 
@@ -103,11 +129,18 @@ public:
     virtual void fetch_merkle_block(const hash_digest& hash,
         merkle_block_fetch_handler handler) const = 0;
 
-    virtual void fetch_compact_block(size_t height,
+    virtual void fetch_merkle_block(size_t height, bloom_filter::ptr filter,
+        filtered_block_fetch_handler handler) const = 0;
+
+    virtual void fetch_merkle_block(const hash_digest& hash,
+        bloom_filter::ptr filter,
+        filtered_block_fetch_handler handler) const = 0;
+
+    virtual void fetch_compact_block(size_t height, uint64_t version,
         compact_block_fetch_handler handler) const = 0;
 
     virtual void fetch_compact_block(const hash_digest& hash,
-        compact_block_fetch_handler handler) const = 0;
+        uint64_t version, compact_block_fetch_handler handler) const = 0;
 
     virtual void fetch_block_height(const hash_digest& hash,
         block_height_fetch_handler handler) const = 0;
@@ -119,6 +152,10 @@ public:
         bool require_confirmed, bool witness,
         transaction_fetch_handler handler) const = 0;
 
+    virtual void fetch_transactions(const hash_list& hashes,
+        bool require_confirmed, bool witness,
+        transactions_fetch_handler handler) const = 0;
+
     virtual void fetch_transaction_position(const hash_digest& hash,
         bool require_confirmed,
         transaction_index_fetch_handler handler) const = 0;
@@ -131,6 +168,11 @@ public:
         const hash_digest& threshold, size_t limit,
         locator_block_headers_fetch_handler handler) const = 0;
 
+    virtual void fetch_locator_block_headers_data(
+        get_headers_const_ptr locator, const hash_digest& threshold,
+        size_t limit,
+        locator_block_headers_data_fetch_handler handler) const = 0;
+
     ////// TODO: must be branch-relative.
     ////virtual void fetch_block_locator(const chain::block::indexes& heights,
     ////    block_locator_fetch_handler handler) const = 0;
@@ -146,9 +188,20 @@ public:
     virtual void fetch_spend(const chain::output_point& outpoint,
         spend_fetch_handler handler) const = 0;
 
+    virtual void fetch_spends(const chain::output_point::list& outpoints,
+        spends_fetch_handler handler) const = 0;
+
     virtual void fetch_history(const short_hash& address_hash, size_t limit,
         size_t from_height, history_fetch_handler handler) const = 0;
 
+    virtual void fetch_history(const short_hash_list& address_hashes,
+        size_t limit, size_t from_height,
+        history_list_fetch_handler handler) const = 0;
+
+    virtual void fetch_history_page(const short_hash& address_hash,
+        size_t cursor, size_t page_size, size_t from_height,
+        history_page_fetch_handler handler) const = 0;
+
     virtual void fetch_stealth(const binary& filter, size_t from_height,
         stealth_fetch_handler handler) const = 0;
 
@@ -180,6 +233,8 @@ public:
     //-------------------------------------------------------------------------
 
     virtual void organize(header_const_ptr header, result_handler handler) = 0;
+    virtual void organize(headers_const_ptr headers,
+        result_handler handler) = 0;
     virtual void organize(transaction_const_ptr tx, result_handler handler) = 0;
     virtual code organize(block_const_ptr block, size_t height) = 0;
 
@@ -22,6 +22,7 @@
 #include <atomic>
 #include <cstddef>
 #include <future>
+#include <map>
 #include <memory>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/blockchain/define.hpp>
@@ -57,10 +58,38 @@ public:
     /// Push a validatable block identifier onto the download subscriber. 
     void prime_validation(const hash_digest& hash, size_t height) const;
 
+    /// Get the heights of missing blocks below the highest awaiting validation.
+    void get_gaps(chain::block::indexes& out_heights, size_t limit) const;
+
+    /// Header reorganization handler, clears popped candidates from ready.
+    bool handle_reorganized(code ec, size_t fork_height,
+        header_const_ptr_list_const_ptr incoming,
+        header_const_ptr_list_const_ptr outgoing);
+
 protected:
     bool stopped() const;
 
 private:
+    // Read-ahead state, shared with a dispatch thread.
+    struct block_reader;
+    typedef std::shared_ptr<block_reader> block_reader_ptr;
+
+    // Ready set, the heights of populated blocks awaiting validation, with
+    // the downloaded block if held (queries do not see held blocks).
+    typedef std::map<size_t, block_const_ptr> ready_blocks;
+    void set_ready(size_t height, block_const_ptr block=nullptr) const;
+    bool is_ready(size_t height) const;
+    block_const_ptr get_ready(size_t height) const;
+    void clear_ready(size_t height, bool above) const;
+    void prune_ready(size_t top_height) const;
+    void release(ready_blocks::const_iterator first,
+        ready_blocks::const_iterator last) const;
+
+    // Read sub-sequence.
+    block_reader_ptr start_read(size_t height);
+    block_const_ptr finish_read(block_reader_ptr reader);
+    void read_block(block_reader_ptr reader);
+
     // Verify sub-sequence.
     code validate(block_const_ptr block);
     bool handle_check(const code& ec, const hash_digest& hash, size_t height);
@@ -73,6 +102,13 @@ private:
     prioritized_mutex& mutex_;
     std::atomic<bool> stopped_;
     std::promise<code> resume_;
+    dispatcher dispatch_;
+
+    // These are guarded by the ready mutex.
+    const size_t held_limit_;
+    mutable size_t held_;
+    mutable ready_blocks ready_;
+    mutable upgrade_mutex ready_mutex_;
     validate_block validator_;
     download_subscriber::ptr downloader_subscriber_;
 };
@@ -51,14 +51,22 @@ public:
     /// validate and organize a header into header pool and store.
     void organize(header_const_ptr header, result_handler handler);
 
+    /// validate and organize a linked run of headers as a single branch.
+    void organize(headers_const_ptr headers, result_handler handler);
+
 protected:
     bool stopped() const;
 
 private:
     // Verify sub-sequence.
     void handle_accept(const code& ec, header_branch::ptr branch, result_handler handler);
+    void handle_accept_run(const code& ec, header_branch::ptr branch,
+        header_const_ptr_list_const_ptr run, result_handler handler);
     void handle_complete(const code& ec, result_handler handler);
 
+    code accept(header_branch::ptr branch, header_const_ptr header) const;
+    code connect(header_branch::ptr branch, size_t count);
+
     // These are thread safe.
     fast_chain& fast_chain_;
     prioritized_mutex& mutex_;
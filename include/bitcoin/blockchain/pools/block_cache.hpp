@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_BLOCK_CACHE_HPP
+#define LIBBITCOIN_BLOCKCHAIN_BLOCK_CACHE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is thread safe.
+/// A bounded, least recently used cache of validated blocks, with witness.
+/// Each entry may hold a maximal block, so capacity bounds memory in blocks.
+/// Blocks are keyed by hash, heights are resolved against the chain indexes
+/// by the caller so that a cached block never outlives its index position.
+/// The compact blocks of a cached block, one for each BIP152 version (1 and
+/// 2), are retained until the block is evicted.
+class BCB_API block_cache
+{
+public:
+    /// Construct a cache of the given number of blocks (zero disables).
+    block_cache(size_t capacity);
+
+    /// The number of blocks in the cache.
+    size_t size() const;
+
+    /// Add the block or make it most recent, evicting the least recent.
+    void add(block_const_ptr block);
+
+    /// Get the block by hash (or null), making it most recent.
+    block_const_ptr get(const hash_digest& hash) const;
+
+    /// Set the compact block of the version for the cached block (ignored if
+    /// not cached or not a BIP152 version).
+    void set_compact(const hash_digest& hash, uint64_t version,
+        compact_block_ptr compact);
+
+    /// Get the compact block of the version by block hash (or null), making
+    /// the block most recent.
+    compact_block_ptr get_compact(const hash_digest& hash,
+        uint64_t version) const;
+
+    /// Remove the block from the cache if it exists.
+    void remove(const hash_digest& hash);
+
+    /// Remove all blocks from the cache.
+    void clear();
+
+private:
+    struct entry
+    {
+        block_const_ptr block;
+        std::array<compact_block_ptr, 2> compacts;
+    };
+
+    typedef std::list<entry> queue;
+    typedef std::unordered_map<hash_digest, queue::iterator> map;
+
+    // This is thread safe.
+    const size_t capacity_;
+
+    // These are guarded by the mutex, and reordered by reads.
+    mutable queue queue_;
+    mutable map map_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
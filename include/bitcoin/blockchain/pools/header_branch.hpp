@@ -45,6 +45,9 @@ public:
     /// Push the header onto the branch, true if chains to top.
     bool push(header_const_ptr header);
 
+    /// Append the header to the top of the branch, true if chains to top.
+    bool append(header_const_ptr header);
+
     /// The parent header of the top header of the branch, if both exist.
     header_const_ptr top_parent() const;
 
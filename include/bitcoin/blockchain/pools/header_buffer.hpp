@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_HEADER_BUFFER_HPP
+#define LIBBITCOIN_BLOCKCHAIN_HEADER_BUFFER_HPP
+
+#include <cstddef>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is thread safe.
+/// A contiguous buffer of headers in headers message wire format, indexed by
+/// height, so that a headers response is a slice of the buffer.
+class BCB_API header_buffer
+{
+public:
+    /// The size of a header with its (zero) transaction count.
+    static const size_t record_size = 81;
+
+    /// The number of headers in the buffer.
+    size_t size() const;
+
+    /// Write a headers message payload of the heights [begin, end), limited
+    /// to the buffer size, returning the number of headers written.
+    size_t to_data(data_chunk& out_data, size_t begin, size_t end) const;
+
+    /// Append the header at the next height.
+    void push(const chain::header& header);
+
+    /// Remove the headers at and above the height.
+    void truncate(size_t height);
+
+    /// Remove all headers from the buffer.
+    void clear();
+
+private:
+    // These are guarded by the mutex.
+    data_chunk buffer_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_TRANSACTION_CACHE_HPP
+#define LIBBITCOIN_BLOCKCHAIN_TRANSACTION_CACHE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is thread safe.
+/// A bounded, least recently used cache of stored transactions with their
+/// confirmation position and height. The cache is split into independently
+/// locked shards (by hash) so that concurrent queries rarely contend.
+class BCB_API transaction_cache
+{
+public:
+    /// Construct a cache of the given number of transactions (zero disables).
+    transaction_cache(size_t capacity);
+
+    /// The number of transactions in the cache.
+    size_t size() const;
+
+    /// The number of successful gets since construction.
+    size_t hits() const;
+
+    /// The number of unsuccessful gets since construction.
+    size_t misses() const;
+
+    /// Add the transaction or make it most recent, evicting the least recent.
+    void add(transaction_const_ptr tx, size_t position, size_t height);
+
+    /// Set the position and height of the transaction if it exists.
+    void confirm(const hash_digest& hash, size_t position, size_t height);
+
+    /// Get the transaction by hash, making it most recent.
+    bool get(transaction_const_ptr& out_tx, size_t& out_position,
+        size_t& out_height, const hash_digest& hash) const;
+
+    /// True if the transaction is cached (not counted, order unchanged).
+    bool exists(const hash_digest& hash) const;
+
+    /// Remove the transaction from the cache if it exists.
+    void remove(const hash_digest& hash);
+
+    /// Remove all transactions from the cache.
+    void clear();
+
+private:
+    struct entry
+    {
+        transaction_const_ptr tx;
+        size_t position;
+        size_t height;
+    };
+
+    typedef std::list<entry> queue;
+    typedef std::unordered_map<hash_digest, queue::iterator> map;
+
+    // These are guarded by the mutex, and reordered by reads.
+    struct shard
+    {
+        mutable queue entries;
+        mutable map lookup;
+        mutable upgrade_mutex mutex;
+    };
+
+    static const size_t shard_count = 16;
+
+    static size_t index(const hash_digest& hash);
+    shard& get_shard(const hash_digest& hash) const;
+
+    // These are thread safe.
+    const size_t capacity_;
+    mutable std::atomic<size_t> hits_;
+    mutable std::atomic<size_t> misses_;
+    mutable std::array<shard, shard_count> shards_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
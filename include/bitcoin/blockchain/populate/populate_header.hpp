@@ -35,9 +35,12 @@ class BCB_API populate_header
 public:
     populate_header(dispatcher& dispatch, const fast_chain& chain);
 
-    /// Populate validation state for the top indexed block.
+    /// Populate chain state for the top header of the branch.
     void populate(header_branch::ptr branch, result_handler&& handler) const;
 
+    /// Populate store metadata for a header with chain state.
+    code populate(const chain::header& header) const;
+
 private:
     bool set_branch_state(header_branch::ptr branch) const;
 };
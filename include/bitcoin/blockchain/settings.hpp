@@ -46,6 +46,17 @@ public:
     uint64_t minimum_output_satoshis;
     uint32_t notify_limit_hours;
     uint32_t reorganization_limit;
+    uint32_t block_cache_capacity;
+    uint32_t transaction_cache_capacity;
+    uint32_t hash_filter_capacity;
+    bool index_spends;
+    uint32_t spend_table_buckets;
+    uint32_t query_threads;
+    uint32_t query_queue_limit;
+    uint32_t block_read_ahead;
+    uint32_t flush_batch_blocks;
+    uint32_t flush_batch_bytes;
+    uint32_t flush_batch_milliseconds;
     config::checkpoint::list checkpoints;
     bool difficult;
     bool retarget;
@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_BLOOM_FILTER_HPP
+#define LIBBITCOIN_BLOCKCHAIN_BLOOM_FILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is not thread safe.
+/// A BIP37 connection bloom filter, as loaded by a peer. Matching a
+/// transaction may insert its outpoints, as directed by the update flags.
+class BCB_API bloom_filter
+{
+public:
+    typedef std::shared_ptr<bloom_filter> ptr;
+
+    /// BIP37 update flags.
+    enum update : uint8_t
+    {
+        update_none = 0,
+        update_all = 1,
+        update_p2pubkey_only = 2,
+        update_mask = 3
+    };
+
+    /// BIP37 limit on the number of hash functions.
+    static const size_t max_hash_functions = 50;
+
+    /// The murmur3 (x86, 32 bit) hash of the data.
+    static uint32_t murmur3(uint32_t seed, const data_slice& data);
+
+    /// Construct a filter from the filterload message values.
+    bloom_filter(const data_chunk& data, uint32_t hash_functions,
+        uint32_t tweak, uint8_t flags);
+
+    /// False if the element has definitely not been inserted.
+    /// A filter of all set bits (or of no bytes) contains every element.
+    bool contains(const data_slice& element) const;
+
+    /// Insert the element into the filter.
+    void insert(const data_slice& element);
+
+    /// True if the transaction matches, inserting outpoints per the flags.
+    bool match(const chain::transaction& tx);
+
+private:
+    void bits(uint32_t* out_bits, const data_slice& element) const;
+    bool match_outputs(const chain::transaction& tx);
+    bool match_inputs(const chain::transaction& tx) const;
+    void update_empty_full();
+
+    data_chunk data_;
+    std::vector<uint32_t> seeds_;
+    const uint8_t flags_;
+    bool full_;
+    bool empty_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_CHAIN_COLUMNS_HPP
+#define LIBBITCOIN_BLOCKCHAIN_CHAIN_COLUMNS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is thread safe.
+/// An in-memory mirror of one store header index (candidate or confirmed).
+/// Each header field is held in its own height-indexed column, so that chain
+/// state population reads contiguous memory instead of the store. Heights are
+/// also indexed by hash in an open addressing table over the hash column.
+class BCB_API chain_columns
+{
+public:
+    chain_columns();
+
+    /// The number of headers in the columns (top height plus one).
+    size_t size() const;
+
+    /// True if there are no headers in the columns.
+    bool empty() const;
+
+    /// Get the height of the top header.
+    bool top(size_t& out_height) const;
+
+    /// Get the hash of the header at the given height.
+    bool get_block_hash(hash_digest& out_hash, size_t height) const;
+
+    /// Get the bits of the header at the given height.
+    bool get_bits(uint32_t& out_bits, size_t height) const;
+
+    /// Get the timestamp of the header at the given height.
+    bool get_timestamp(uint32_t& out_timestamp, size_t height) const;
+
+    /// Get the version of the header at the given height.
+    bool get_version(uint32_t& out_version, size_t height) const;
+
+    /// Get the median time past of the header at the given height.
+    bool get_median_time_past(uint32_t& out_time, size_t height) const;
+
+    /// Get the validation state (flags) of the header at the given height.
+    bool get_state(uint8_t& out_state, size_t height) const;
+
+    /// Get the cumulative work from genesis through the given height.
+    bool get_cumulative_work(uint256_t& out_work, size_t height) const;
+
+    /// Get the work of all headers above the given height (zero if none).
+    bool get_work(uint256_t& out_work, size_t above_height) const;
+
+    /// Get the lowest height at which cumulative work reaches the given work.
+    bool get_height(size_t& out_height, const uint256_t& cumulative_work) const;
+
+    /// Get the height and validation state of the header by hash.
+    bool find(size_t& out_height, uint8_t& out_state,
+        const hash_digest& block_hash) const;
+
+    /// True if the header is in the columns.
+    bool exists(const hash_digest& block_hash) const;
+
+    /// Get the empty and the populated headers in the height range, each
+    /// excluding the headers with any of the given state flags.
+    void get_schedule(config::checkpoint::list& out_empty,
+        config::checkpoint::list& out_populated, size_t from_height,
+        size_t count, uint8_t empty_excluded, uint8_t populated_excluded) const;
+
+    /// Append the header at the next height.
+    void push(const chain::header& header, uint8_t state);
+
+    /// Set the validation state of the header at the given height.
+    bool set_state(size_t height, uint8_t state);
+
+    /// Set whether the block at the given height is populated with its txs.
+    bool set_populated(size_t height, bool populated);
+
+    /// Set the state and populated flag of the header at the given height,
+    /// only if it is the header of the given hash.
+    bool set_block(const hash_digest& block_hash, size_t height,
+        uint8_t state, bool populated);
+
+    /// Remove all headers at and above the given height.
+    void truncate(size_t height);
+
+    /// Remove all headers.
+    void clear();
+
+protected:
+    typedef std::vector<uint32_t> slots;
+
+    uint32_t median_time_past() const;
+    size_t home(const hash_digest& block_hash) const;
+    size_t slot(const hash_digest& block_hash) const;
+    void insert(size_t height);
+    void erase(size_t height);
+    void rehash(size_t capacity);
+
+private:
+    // These are guarded by the mutex.
+    hash_list hashes_;
+    std::vector<uint32_t> bits_;
+    std::vector<uint32_t> timestamps_;
+    std::vector<uint32_t> versions_;
+    std::vector<uint32_t> median_time_pasts_;
+    std::vector<uint8_t> states_;
+    std::vector<bool> populated_;
+    std::vector<uint256_t> works_;
+
+    // Each slot holds height plus one (zero is empty), keyed by hashes_.
+    slots slots_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_HASH_FILTER_HPP
+#define LIBBITCOIN_BLOCKCHAIN_HASH_FILTER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is thread safe.
+/// A blocked bloom filter of hashes, each hash setting bits within a single
+/// cache line. A hash that has been added is always reported as possibly
+/// present, so a negative result is definitive. Hashes cannot be removed.
+class BCB_API hash_filter
+{
+public:
+    /// Construct a filter sized for the number of hashes (zero disables).
+    hash_filter(size_t capacity);
+
+    /// Add the hash to the filter.
+    void add(const hash_digest& hash);
+
+    /// False if the hash has definitely not been added (true if disabled).
+    bool contains(const hash_digest& hash) const;
+
+private:
+    typedef std::atomic<uint64_t> word;
+
+    static const size_t words_per_block = 8;
+    static const size_t bits_per_hash = 8;
+    static const size_t bits_per_entry = 10;
+
+    size_t block(const hash_digest& hash) const;
+    static uint64_t bit(const hash_digest& hash, size_t index);
+
+    // These are thread safe.
+    std::vector<word> words_;
+    const size_t mask_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
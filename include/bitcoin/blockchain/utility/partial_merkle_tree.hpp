@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_PARTIAL_MERKLE_TREE_HPP
+#define LIBBITCOIN_BLOCKCHAIN_PARTIAL_MERKLE_TREE_HPP
+
+#include <cstddef>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is not thread safe.
+/// The BIP37 partial merkle tree of a block, the hashes and flags of a depth
+/// first walk that proves the matched transactions against the merkle root.
+class BCB_API partial_merkle_tree
+{
+public:
+    /// Construct the tree of the transaction hashes, matches in tx order.
+    partial_merkle_tree(const hash_list& leaves,
+        const std::vector<bool>& matches);
+
+    /// The hashes of the walk, in order.
+    const hash_list& hashes() const;
+
+    /// The flag bits of the walk, in order from the low bit of each byte.
+    const data_chunk& flags() const;
+
+private:
+    typedef std::vector<bool> match_list;
+
+    void walk(size_t level, size_t index, const std::vector<hash_list>& hashes,
+        const std::vector<match_list>& matches);
+
+    hash_list hashes_;
+    data_chunk flags_;
+    size_t bits_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_QUERY_EXECUTOR_HPP
+#define LIBBITCOIN_BLOCKCHAIN_QUERY_EXECUTOR_HPP
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <set>
+#include <thread>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is thread safe.
+/// Executes queries on a thread pool, with a concurrency and queue limit for
+/// each class of query. Queries of a class run in order of submission, and a
+/// class at its concurrency limit does not consume threads of other classes.
+/// If the pool has no threads each query is executed on the calling thread.
+class BCB_API query_executor
+{
+public:
+    typedef std::function<void()> query;
+
+    struct limits
+    {
+        typedef std::vector<limits> list;
+
+        size_t concurrency;
+        size_t queue;
+    };
+
+    /// Construct an executor of the given query classes (by index).
+    query_executor(threadpool& pool, const limits::list& classes);
+
+    /// The number of queries of the class waiting for a thread.
+    size_t pending(size_t query_class) const;
+
+    /// Execute the query, false if the class queue is full or stopped.
+    bool execute(size_t query_class, const query& handler);
+
+    /// Reject subsequent queries and wait for queued and running queries to
+    /// complete, so that each accepted query is executed before return.
+    /// Called from a query this does not wait (it would wait on itself), and
+    /// returns false. A subsequent stop from another thread then waits.
+    bool stop();
+
+private:
+    struct state
+    {
+        limits limit;
+        size_t running;
+        std::deque<query> queue;
+    };
+
+    void run(size_t query_class, query handler);
+    bool idle() const;
+
+    // This is thread safe.
+    dispatcher dispatch_;
+
+    // These are guarded by the mutex.
+    bool stopped_;
+    std::vector<state> classes_;
+    std::set<std::thread::id> executing_;
+    std::promise<void> idle_;
+    std::shared_future<void> complete_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_SPEND_INDEX_HPP
+#define LIBBITCOIN_BLOCKCHAIN_SPEND_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is thread safe.
+/// A persistent index of confirmed outpoints to the location of their
+/// spending input, in fixed width rows chained from a fixed set of buckets.
+/// The table is memory mapped, as are the tables of the store.
+/// Outpoints are keyed by a truncated hash, so a key may collide and each
+/// spender must be verified against the outpoint by the caller.
+class BCB_API spend_index
+{
+public:
+    /// The confirmed location of a spending input.
+    struct spender
+    {
+        typedef std::vector<spender> list;
+
+        uint32_t height;
+        uint32_t position;
+        uint32_t input;
+    };
+
+    /// Construct an index over the file, with a fixed number of buckets.
+    spend_index(const boost::filesystem::path& filename, size_t buckets);
+
+    /// Open the index file, creating it if missing or differently sized.
+    bool open();
+
+    /// Commit the index header and close the file.
+    bool close();
+
+    /// The height through which spends are indexed, max_size_t if none.
+    size_t height() const;
+
+    /// Set the height through which spends are indexed, without commit.
+    void set_height(size_t height);
+
+    /// Uncommit the index, so that an interrupted write is not trusted.
+    /// This is a no-op if the index is already uncommitted.
+    bool begin_write();
+
+    /// Commit the index through the height and flush the file.
+    bool end_write(size_t height);
+
+    /// The number of spends in the index.
+    size_t size() const;
+
+    /// Get the candidate spenders of the outpoint (including collisions).
+    void get(spender::list& out_spenders,
+        const chain::output_point& outpoint) const;
+
+    /// Add the spender of the outpoint.
+    void add(const chain::output_point& outpoint, const spender& spend);
+
+    /// Remove the spenders of the outpoint above the height.
+    void remove(const chain::output_point& outpoint, size_t above_height);
+
+    /// Remove all spends from the index (recreates the file).
+    bool clear();
+
+private:
+    struct row
+    {
+        uint64_t key;
+        uint64_t next;
+        spender spend;
+    };
+
+    static uint64_t key(const chain::output_point& outpoint);
+
+    bool create();
+    bool read_header();
+    bool write_header();
+    void read_spenders(spender::list& out_spenders, uint64_t key) const;
+    uint64_t bucket_offset(uint64_t key) const;
+    uint64_t row_offset(uint64_t link) const;
+    static uint64_t read_link(const uint8_t* buffer, uint64_t offset);
+    static void write_link(uint8_t* buffer, uint64_t offset, uint64_t link);
+    static row read_row(const uint8_t* buffer, uint64_t offset);
+    static void write_row(uint8_t* buffer, uint64_t offset, const row& value);
+
+    // These are thread safe.
+    const boost::filesystem::path filename_;
+    const uint64_t buckets_;
+
+    // These are guarded by the mutex (the table remap is guarded by the file).
+    mutable database::file_storage file_;
+    bool opened_;
+    bool writing_;
+    uint64_t rows_;
+    uint64_t size_;
+    uint64_t height_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
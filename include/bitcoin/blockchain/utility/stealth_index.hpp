@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_STEALTH_INDEX_HPP
+#define LIBBITCOIN_BLOCKCHAIN_STEALTH_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is thread safe.
+/// An index of confirmed stealth outputs. Prefixes and heights are held in
+/// dense columns so that a scan tests a run of rows without branching. Rows
+/// must be added in height order, so that reorganization pops them.
+/// Rows are appended to a memory mapped file, from which the columns are
+/// loaded on open, so the index is not rebuilt on each start.
+class BCB_API stealth_index
+{
+public:
+    struct record
+    {
+        typedef std::vector<record> list;
+
+        uint32_t prefix;
+        size_t height;
+        hash_digest ephemeral_key;
+        short_hash public_key_hash;
+        hash_digest transaction_hash;
+    };
+
+    /// Construct an index over the file.
+    stealth_index(const boost::filesystem::path& filename);
+
+    /// Open the index file and load its rows, creating it if missing.
+    bool open();
+
+    /// Commit the index header and close the file.
+    bool close();
+
+    /// The number of records in the index.
+    size_t size() const;
+
+    /// The height through which blocks are indexed, max_size_t if none.
+    size_t top() const;
+
+    /// Set the height through which blocks are indexed, without commit.
+    void set_top(size_t height);
+
+    /// Uncommit the index, so that an interrupted write is not trusted.
+    /// This is a no-op if the index is already uncommitted.
+    bool begin_write();
+
+    /// Commit the index through the height and flush the file.
+    bool end_write(size_t height);
+
+    /// Add the record to the index.
+    void add(const record& record);
+
+    /// Remove the records above the height, and lower the top to it.
+    void remove(size_t above_height);
+
+    /// Get the records at or above the height with prefixes matching the
+    /// filter (a filter of more than 32 bits matches nothing).
+    void scan(record::list& out_records, const binary& filter,
+        size_t from_height) const;
+
+    /// Remove all records from the index (recreates the file).
+    bool clear();
+
+private:
+    struct payload
+    {
+        hash_digest ephemeral_key;
+        short_hash public_key_hash;
+        hash_digest transaction_hash;
+    };
+
+    bool create();
+    bool load();
+    bool write_header();
+
+    // This is thread safe.
+    const boost::filesystem::path filename_;
+
+    // These are guarded by the mutex.
+    database::file_storage file_;
+    bool opened_;
+    bool writing_;
+    size_t top_;
+    std::vector<uint32_t> prefixes_;
+    std::vector<uint32_t> heights_;
+    std::vector<payload> payloads_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_WRITE_BATCH_HPP
+#define LIBBITCOIN_BLOCKCHAIN_WRITE_BATCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is thread safe.
+/// Bounds a group of store writes that are made durable together, by block
+/// count and bytes. The caller bounds the time from the opening write.
+class BCB_API write_batch
+{
+public:
+    /// Construct a batch of the given bounds (zero blocks disables).
+    write_batch(size_t blocks, size_t bytes);
+
+    /// True if writes are grouped.
+    bool enabled() const;
+
+    /// Open the group for a write, true if this opens a new group.
+    bool begin();
+
+    /// Add a write of the given blocks and bytes, true if the group is
+    /// complete. A completed group is reset, and the caller must commit it.
+    bool add(size_t blocks, size_t bytes);
+
+    /// True if the group is open, and resets it (the caller commits).
+    bool reset();
+
+private:
+    // These are thread safe.
+    const size_t blocks_limit_;
+    const size_t bytes_limit_;
+
+    // These are guarded by the mutex.
+    bool open_;
+    size_t blocks_;
+    size_t bytes_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
@@ -43,6 +43,9 @@ public:
     code check(header_const_ptr block) const;
     void accept(header_branch::ptr branch, result_handler handler) const;
 
+    /// Populate and accept a header for which chain state is set.
+    code accept(const chain::header& header) const;
+
 protected:
     bool stopped() const;
 
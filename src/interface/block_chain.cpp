@@ -19,17 +19,25 @@
 #include <bitcoin/blockchain/interface/block_chain.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <future>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <random>
 #include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database.hpp>
 #include <bitcoin/blockchain/settings.hpp>
 #include <bitcoin/blockchain/pools/header_branch.hpp>
 #include <bitcoin/blockchain/populate/populate_chain_state.hpp>
+#include <bitcoin/blockchain/utility/partial_merkle_tree.hpp>
 
 namespace libbitcoin {
 namespace blockchain {
@@ -40,17 +48,95 @@ using namespace std::placeholders;
 
 #define NAME "block_chain"
 
+// Blocks are read in parallel only with at least this many txs per thread.
+static constexpr size_t transactions_per_reader = 64;
+
+// The persisted indexes are committed (flushed) at this interval while
+// populated.
+static constexpr size_t index_commit_interval = 1000;
+
+// Compact block nonces must not be predictable by peers (BIP152).
+static uint64_t random_seed()
+{
+    std::random_device device;
+    return (uint64_t(device()) << 32) | device();
+}
+
+// A queued reader may start after the caller has returned, in which case it
+// finds no unclaimed transactions and does not touch the caller's list.
+struct block_chain::transaction_reader
+{
+    std::vector<file_offset> offsets;
+    transaction::list* transactions;
+    bool witness;
+    std::atomic<size_t> next;
+    std::atomic<size_t> done;
+    std::atomic<bool> failed;
+    std::promise<void> complete;
+};
+
+// History pages are resumed from the open row iterator of the prior page.
+static constexpr size_t history_cursor_limit = 1024;
+
+// The rows are held with the iterator, which may refer to them.
+struct block_chain::history_cursor
+{
+    typedef decltype(std::declval<const address_result&>().begin()) iterator;
+
+    history_cursor(address_result&& result)
+      : rows(std::move(result)), row(rows.begin())
+    {
+    }
+
+    const address_result rows;
+    iterator row;
+};
+
+// Blocks that have been read but not yet delivered are held in height order.
+struct block_chain::block_stream
+{
+    size_t to_height;
+    bool witness;
+    block_stream_handler handler;
+
+    // These are guarded by the mutex.
+    size_t next_read;
+    size_t next_deliver;
+    bool delivering;
+    bool stopped;
+    std::map<size_t, std::pair<code, block_const_ptr>> ready;
+    upgrade_mutex mutex;
+};
+
+// private
+// Server queries (history, stealth) are limited to half of the query threads,
+// so that they cannot starve the block, transaction and locator queries.
+query_executor::limits::list block_chain::query_limits(
+    const blockchain::settings& settings)
+{
+    const size_t threads = settings.query_threads;
+    const size_t queue = settings.query_queue_limit;
+    query_executor::limits::list limits(query_classes, { threads, queue });
+    limits[server_query].concurrency = std::max(threads / 2u, size_t(1));
+    return limits;
+}
+
 block_chain::block_chain(threadpool& pool,
     const blockchain::settings& settings,
     const database::settings& database_settings,
     const bc::settings& bitcoin_settings)
   : database_(database_settings),
     stopped_(true),
+    confirmed_epoch_(0),
     fork_point_({ null_hash, 0 }),
     settings_(settings),
     bitcoin_settings_(bitcoin_settings),
     chain_state_populator_(*this, settings, bitcoin_settings),
     index_addresses_(database_settings.index_addresses),
+    write_batch_(database_settings.flush_writes ? 0 :
+        settings.flush_batch_blocks, settings.flush_batch_bytes),
+    flush_timer_(std::make_shared<deadline>(pool,
+        asio::milliseconds(settings.flush_batch_milliseconds))),
 
     // Enable block/header priority when write flush enabled (performance).
     validation_mutex_(database_settings.flush_writes),
@@ -58,12 +144,24 @@ block_chain::block_chain(threadpool& pool,
     // Metadata pools.
     header_pool_(settings.reorganization_limit),
     transaction_pool_(settings),
+    block_cache_(settings.block_cache_capacity),
+    transaction_cache_(settings.transaction_cache_capacity),
+    nonce_generator_(random_seed()),
+    transaction_filter_(settings.hash_filter_capacity),
+    transaction_filter_primed_(false),
+    spend_index_(database_settings.directory / "spend_table",
+        settings.spend_table_buckets),
+    stealth_index_(database_settings.directory / "stealth_table"),
 
     // Create dispatchers for priority and non-priority operations.
     priority_pool_(thread_ceiling(settings.cores) + 1u, priority(settings.priority)),
     priority_(priority_pool_, NAME "_priority"),
     dispatch_(pool, NAME "_dispatch"),
 
+    // Queries execute on the calling thread if there are no query threads.
+    query_pool_(settings.query_threads),
+    query_executor_(query_pool_, query_limits(settings)),
+
     // Organizers use priority dispatch and/or non-priority thread pool.
     block_organizer_(validation_mutex_, priority_, pool, *this, settings,
         bitcoin_settings),
@@ -108,7 +206,7 @@ bool block_chain::get_top(config::checkpoint& out_checkpoint,
 
 bool block_chain::get_top_height(size_t& out_height, bool candidate) const
 {
-    return database_.blocks().top(out_height, candidate);
+    return columns(candidate).top(out_height);
 }
 
 bool block_chain::get_header(chain::header& out_header, size_t height,
@@ -127,35 +225,29 @@ bool block_chain::get_header(chain::header& out_header, size_t height,
 bool block_chain::get_header(chain::header& out_header, size_t& out_height,
     const hash_digest& block_hash, bool candidate) const
 {
-    auto result = database_.blocks().get(block_hash);
+    size_t height;
+    uint8_t state;
 
-    if (!result)
+    // The only way to know if a header is indexed is from its presence in the
+    // index. It will not be marked as a candidate until validated as such.
+    if (!columns(candidate).find(height, state, block_hash))
         return false;
 
-    const auto height = result.height();
+    auto result = database_.blocks().get(height, candidate);
 
-    // The only way to know if a header is indexed is from its presence in the
-    // index. It will not be marked as a candidate until validated as such.
-    if (database_.blocks().get(height, candidate))
-    {
-        out_header = result.header();
-        out_height = height;
-        return true;
-    }
+    if (!result)
+        return false;
 
-    return false;
+    // Since header() is const this may not actually move without a cast.
+    out_header = std::move(result.header());
+    out_height = height;
+    return true;
 }
 
 bool block_chain::get_block_hash(hash_digest& out_hash, size_t height,
     bool candidate) const
 {
-    const auto result = database_.blocks().get(height, candidate);
-
-    if (!result)
-        return false;
-
-    out_hash = result.hash();
-    return true;
+    return columns(candidate).get_block_hash(out_hash, height);
 }
 
 bool block_chain::get_block_error(code& out_error,
@@ -173,67 +265,38 @@ bool block_chain::get_block_error(code& out_error,
 bool block_chain::get_bits(uint32_t& out_bits, size_t height,
     bool candidate) const
 {
-    auto result = database_.blocks().get(height, candidate);
-
-    if (!result)
-        return false;
-
-    out_bits = result.bits();
-    return true;
+    return columns(candidate).get_bits(out_bits, height);
 }
 
 bool block_chain::get_timestamp(uint32_t& out_timestamp, size_t height,
     bool candidate) const
 {
-    auto result = database_.blocks().get(height, candidate);
-
-    if (!result)
-        return false;
-
-    out_timestamp = result.timestamp();
-    return true;
+    return columns(candidate).get_timestamp(out_timestamp, height);
 }
 
 bool block_chain::get_version(uint32_t& out_version, size_t height,
     bool candidate) const
 {
-    auto result = database_.blocks().get(height, candidate);
-
-    if (!result)
-        return false;
-
-    out_version = result.version();
-    return true;
+    return columns(candidate).get_version(out_version, height);
 }
 
-bool block_chain::get_work(uint256_t& out_work, const uint256_t& overcome,
+// The work column is a prefix sum, so overcome is not required to bound it.
+bool block_chain::get_work(uint256_t& out_work, const uint256_t&,
     size_t above_height, bool candidate) const
 {
     size_t top;
     out_work = 0;
 
-    if (!database_.blocks().top(top, candidate))
+    if (!get_top_height(top, candidate))
         return false;
 
-    // Set overcome to zero to bypass early exit.
-    const auto no_maximum = overcome.is_zero();
-
-    for (auto height = top; (height > above_height) &&
-        (no_maximum || out_work <= overcome); --height)
-    {
-        const auto result = database_.blocks().get(height, candidate);
-
-        if (!result)
-            return false;
-
-        // Candidate chain is counted only to top validated block.
-        if (candidate && !is_valid(result.state()))
-            break;
-
-        out_work += chain::header::proof(result.bits());
-    }
+    // Candidate chain is counted only to top validated block. Candidates are
+    // validated in height order, so any valid candidates are a prefix of the
+    // index. An invalid top therefore implies no work above any height.
+    if (candidate && !is_valid(get_block_state(top, true)))
+        return true;
 
-    return true;
+    return columns(candidate).get_work(out_work, above_height);
 }
 
 bool block_chain::get_downloadable(hash_digest& out_hash, size_t height) const
@@ -268,6 +331,44 @@ void block_chain::prime_validation(const hash_digest& hash,
     block_organizer_.prime_validation(hash, height);
 }
 
+void block_chain::get_download_schedule(
+    config::checkpoint::list& out_downloadable,
+    config::checkpoint::list& out_validatable, size_t from_height,
+    size_t count) const
+{
+    candidate_columns_.get_schedule(out_downloadable, out_validatable,
+        from_height, count, block_state::failed,
+        block_state::failed | block_state::valid);
+}
+
+// private
+// Populated candidates above the top valid candidate were not validated
+// before shutdown, so queue each for validation.
+bool block_chain::prime_candidates() const
+{
+    size_t top;
+
+    if (!candidate_columns_.top(top))
+        return false;
+
+    config::checkpoint::list downloadable;
+    config::checkpoint::list validatable;
+    const auto from_height = top_valid_candidate_state()->height() + 1u;
+    get_download_schedule(downloadable, validatable, from_height,
+        top - from_height + 1u);
+
+    for (const auto& block: validatable)
+        prime_validation(block.hash(), block.height());
+
+    return true;
+}
+
+void block_chain::get_download_gaps(chain::block::indexes& out_heights,
+    size_t limit) const
+{
+    block_organizer_.get_gaps(out_heights, limit);
+}
+
 void block_chain::populate_header(const chain::header& header) const
 {
     database_.blocks().get_header_metadata(header);
@@ -293,23 +394,38 @@ bool block_chain::populate_output(const chain::output_point& outpoint,
 
 uint8_t block_chain::get_block_state(size_t height, bool candidate) const
 {
-    return database_.blocks().get(height, candidate).state();
+    uint8_t state;
+
+    // The store is only queried for a height above the indexed top.
+    return columns(candidate).get_state(state, height) ? state :
+        database_.blocks().get(height, candidate).state();
 }
 
 uint8_t block_chain::get_block_state(const hash_digest& block_hash) const
 {
-    return database_.blocks().get(block_hash).state();
+    size_t height;
+    uint8_t state;
+
+    // The store is only queried for a header that is not indexed.
+    return candidate_columns_.find(height, state, block_hash) ||
+        confirmed_columns_.find(height, state, block_hash) ? state :
+        database_.blocks().get(block_hash).state();
 }
 
 block_const_ptr block_chain::get_block(size_t height, bool witness,
     bool candidate) const
 {
-    const auto cached = last_block_.load();
+    hash_digest hash;
+
+    // Try the cache first, the cached block must be indexed at the height.
+    // Cached blocks carry witness data, so only serve them when requested.
+    if (witness && get_block_hash(hash, height, candidate))
+    {
+        const auto cached = block_cache_.get(hash);
 
-    // Try the cached block first.
-    if (!candidate && cached && cached->header().metadata.state &&
-        cached->header().metadata.state->height() == height)
-        return cached;
+        if (cached)
+            return cached;
+    }
 
     const auto result = database_.blocks().get(height, candidate);
 
@@ -341,169 +457,715 @@ header_const_ptr block_chain::get_header(size_t height, bool candidate) const
     return std::make_shared<const header>(result.header());
 }
 
-// Writers
+// Columns.
 // ----------------------------------------------------------------------------
 
 // private
-void block_chain::index_block(block_const_ptr block)
+chain_columns& block_chain::columns(bool candidate)
 {
-    if (!index_addresses_)
-        return;
+    return candidate ? candidate_columns_ : confirmed_columns_;
+}
 
-    code ec;
-    if ((ec = database_.index(*block)))
+// private
+const chain_columns& block_chain::columns(bool candidate) const
+{
+    return candidate ? candidate_columns_ : confirmed_columns_;
+}
+
+// private
+// Mirror the store index at and above the given height into the columns.
+bool block_chain::index_columns(size_t from_height, bool candidate)
+{
+    size_t top;
+    auto& index = columns(candidate);
+
+    // Columns are contiguous, so never leave a gap below the first height.
+    from_height = std::min(from_height, index.size());
+    index.truncate(from_height);
+
+    // Confirmed headers are also buffered for headers responses.
+    if (!candidate)
+        confirmed_headers_.truncate(from_height);
+
+    if (!database_.blocks().top(top, candidate))
+        return false;
+
+    for (auto height = from_height; height <= top; ++height)
     {
-        LOG_FATAL(LOG_BLOCKCHAIN)
-            << "Failure in block payment indexing, store is now corrupt: "
-            << ec.message();
+        const auto result = database_.blocks().get(height, candidate);
 
-        // In the case of a store failure the server stops processing.
-        stop();
+        if (!result)
+            return false;
+
+        const auto header = result.header();
+        index.push(header, result.state());
+
+        if (result.transaction_count() != 0)
+            index.set_populated(height, true);
+
+        if (!candidate)
+            confirmed_headers_.push(header);
     }
+
+    return true;
 }
 
 // private
-void block_chain::index_transaction(transaction_const_ptr tx)
+// Refresh the column states (and population) of existing entries from store.
+void block_chain::index_states(size_t from_height, size_t to_height,
+    bool candidate)
 {
-    if (!index_addresses_ || tx->metadata.existed)
+    size_t top;
+    auto& index = columns(candidate);
+
+    if (!index.top(top))
         return;
 
-    code ec;
-    if ((ec = database_.index(*tx)))
-    {
-        LOG_FATAL(LOG_BLOCKCHAIN)
-            << "Failure in transaction payment indexing, store is now corrupt: "
-            << ec.message();
+    to_height = std::min(to_height, top);
 
-        // In the case of a store failure the server stops processing.
-        stop();
+    for (auto height = from_height; height <= to_height; ++height)
+    {
+        const auto result = database_.blocks().get(height, candidate);
+        index.set_state(height, result.state());
+        index.set_populated(height, result.transaction_count() != 0);
     }
 }
 
-code block_chain::store(transaction_const_ptr tx)
+// private
+// Refresh the column state of the header, if it is indexed.
+void block_chain::index_state(const hash_digest& block_hash)
 {
-    const auto state = tx->metadata.state;
-
-    if (!state)
-        return error::operation_failed;
-
-    // Clear chain state for store, index_transaction and notify.
-    tx->metadata.state.reset();
+    const auto result = database_.blocks().get(block_hash);
 
-    code ec;
-    if ((ec = database_.store(*tx, state->enabled_forks())))
-        return ec;
+    if (!result)
+        return;
 
-    // Payment indexing is asynchronous, after tx is stored. Therefore
-    // it is possible for a tx to be in any existing state and not be indexed.
-    if (index_addresses_ && !tx->metadata.existed)
-        dispatch_.concurrent(&block_chain::index_transaction, this, tx);
+    hash_digest hash;
+    const auto height = result.height();
 
-    notify(tx);
+    if (candidate_columns_.get_block_hash(hash, height) && hash == block_hash)
+        candidate_columns_.set_state(height, result.state());
 
-    // Restore chain state for last_transaction_ cache.
-    tx->metadata.state = state;
-    last_transaction_.store(tx);
-    return ec;
+    if (confirmed_columns_.get_block_hash(hash, height) && hash == block_hash)
+        confirmed_columns_.set_state(height, result.state());
 }
 
-code block_chain::reorganize(const config::checkpoint& fork,
-    header_const_ptr_list_const_ptr incoming)
+// private
+// Get the height of the header from either index, otherwise from the store.
+bool block_chain::get_height(size_t& out_height,
+    const hash_digest& block_hash) const
 {
-    if (incoming->empty())
-        return error::operation_failed;
+    uint8_t state;
 
-    const auto top = incoming->back();
-    const auto top_state = top->metadata.state;
+    if (confirmed_columns_.find(out_height, state, block_hash) ||
+        candidate_columns_.find(out_height, state, block_hash))
+        return true;
 
-    if (!top_state)
-        return error::operation_failed;
+    const auto result = database_.blocks().get(block_hash);
 
-    // TODO: if leave uncleared do not need header.median_time_past.
-    ////// Clear incoming chain state for reorganize and notify.
-    ////std::for_each(incoming->begin(), incoming->end(),
-    ////    [](header_const_ptr header) { header->metadata.state.reset(); });
+    if (!result)
+        return false;
 
-    code ec;
-    auto fork_height = fork.height();
-    const auto outgoing = std::make_shared<header_const_ptr_list>();
+    out_height = result.height();
+    return true;
+}
 
-    // This unmarks candidate txs and spent outputs (may have been validated).
-    if ((ec = database_.reorganize(fork, incoming, outgoing)))
-        return ec;
+// private
+// Confirm cached transactions of incoming blocks, drop those of outgoing.
+void block_chain::cache_transactions(size_t fork_height,
+    block_const_ptr_list_const_ptr incoming,
+    block_const_ptr_list_const_ptr outgoing)
+{
+    for (const auto block: *outgoing)
+        for (const auto& tx: block->transactions())
+            transaction_cache_.remove(tx.hash());
 
-    // Don't add outgoing because only populated after reorganize and at that
-    // point the headers are no longer indexed (populator requires indexation).
-    if (!incoming->empty())
-    {
-        header_pool_.remove(incoming);
-        header_pool_.prune(top_state->height());
-    }
+    auto height = fork_height;
 
-    // If confirmed fork point is above candidate fork point then lower it.
-    if (fork_point().height() > fork_height)
+    for (const auto block: *incoming)
     {
-        // Set new fork point and recompute confirmed work from it.
-        set_fork_point(fork);
-        set_confirmed_work();
+        size_t position = 0;
+        ++height;
 
-        // When fork point is lowered the top valid candidate is at fork point.
-        auto top_valid = chain_state_populator_.populate(fork_height, true);
-        set_top_valid_candidate_state(top_valid);
-        set_candidate_work(0);
+        for (const auto& tx: block->transactions())
+            transaction_cache_.confirm(tx.hash(), position++, height);
     }
-
-    set_top_candidate_state(top_state);
-    notify(fork_height, incoming, outgoing);
-    return ec;
 }
 
-code block_chain::update(block_const_ptr block, size_t height)
+// Spends.
+// ----------------------------------------------------------------------------
+
+// private
+// Open the index, which is populated from its committed height in the
+// background. An uncommitted index (new or interrupted) is cleared and so is
+// rebuilt from genesis (slow), during which spend queries fail.
+bool block_chain::open_spends()
 {
-    code error_code;
-    const auto& metadata = block->header().metadata;
+    size_t top;
 
-    if (!metadata.error)
-    {
-        // Store or connect each transaction and set tx link metadata.
-        if ((error_code = database_.update(*block, height)))
-            return error_code;
-    }
-    else if (metadata.validated)
-    {
-        // Set block validation error state and error code.
-        // Never set valid on update as validation handling would be skipped.
-        error_code = database_.invalidate(block->header(), metadata.error);
-    }
+    if (!spend_index_.open() || !confirmed_columns_.top(top))
+        return false;
 
-    return error_code;
-}
+    const auto height = spend_index_.height();
 
-code block_chain::invalidate(const chain::header& header, const code& error)
-{
-    // Mark candidate header as invalid.
-    return database_.invalidate(header, error);
+    // The store cannot be below a committed index, but if so it is rebuilt.
+    return (height != max_size_t && height <= top) || spend_index_.clear();
 }
 
-// Mark candidate block and descendants as invalid and pop them.
-code block_chain::invalidate(block_const_ptr block, size_t block_height)
+// private
+void block_chain::index_spends(const chain::block& block, size_t height)
 {
-    const auto& header = block->header();
-    BITCOIN_ASSERT(header.metadata.error);
+    uint32_t position = 0;
 
-    size_t top;
-    if (!get_top_height(top, true))
-        return error::operation_failed;
+    for (const auto& tx: block.transactions())
+    {
+        uint32_t input = 0;
 
-    hash_digest fork_hash;
-    const auto fork_height = block_height - 1u;
-    if (!get_block_hash(fork_hash, fork_height, true))
-        return error::operation_failed;
+        if (!tx.is_coinbase())
+            for (const auto& in: tx.inputs())
+                spend_index_.add(in.previous_output(),
+                    { static_cast<uint32_t>(height), position, input++ });
 
-    code ec;
-    const config::checkpoint fork{ fork_hash, fork_height };
-    const auto outgoing = std::make_shared<header_const_ptr_list>();
-    const auto incoming = std::make_shared<header_const_ptr_list>();
+        ++position;
+    }
+}
+
+// private
+// Remove the spends of outgoing blocks and add those of incoming blocks.
+// The index is uncommitted while written, so an interruption is rebuilt.
+bool block_chain::index_spends(size_t fork_height,
+    block_const_ptr_list_const_ptr incoming,
+    block_const_ptr_list_const_ptr outgoing)
+{
+    const auto indexed = spend_index_.height();
+
+    // Population has not yet reached the fork point (it then continues).
+    if (indexed == max_size_t || indexed < fork_height)
+        return true;
+
+    if (!spend_index_.begin_write())
+        return false;
+
+    for (const auto block: *outgoing)
+        for (const auto& tx: block->transactions())
+            if (!tx.is_coinbase())
+                for (const auto& input: tx.inputs())
+                    spend_index_.remove(input.previous_output(), fork_height);
+
+    auto height = fork_height;
+
+    for (const auto block: *incoming)
+        index_spends(*block, ++height);
+
+    return spend_index_.end_write(height);
+}
+
+// private
+// Verify the candidate spenders against the store, as index keys collide.
+bool block_chain::get_spender(chain::input_point& out_spender,
+    const chain::output_point& outpoint) const
+{
+    spend_index::spender::list spenders;
+    spend_index_.get(spenders, outpoint);
+
+    for (const auto& spender: spenders)
+    {
+        const auto block = database_.blocks().get(spender.height, false);
+
+        if (!block || spender.position >= block.transaction_count())
+            continue;
+
+        size_t position = 0;
+
+        for (const auto offset: block)
+        {
+            if (position++ != spender.position)
+                continue;
+
+            const auto tx = database_.transactions().get(offset)
+                .transaction(false);
+
+            if (spender.input < tx.inputs().size() &&
+                tx.inputs()[spender.input].previous_output() == outpoint)
+            {
+                out_spender = { tx.hash(), spender.input };
+                return true;
+            }
+
+            break;
+        }
+    }
+
+    return false;
+}
+
+// Writers
+// ----------------------------------------------------------------------------
+
+// private
+void block_chain::index_block(block_const_ptr block)
+{
+    if (!index_addresses_)
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    // Indexing is asynchronous, but it is a store write, so it is batched.
+    validation_mutex_.lock_low_priority();
+
+    code ec;
+    if ((ec = begin_write()) || (ec = database_.index(*block)) ||
+        (ec = commit_write(0, 0)))
+    {
+        abort_write(ec);
+        validation_mutex_.unlock_low_priority();
+        //---------------------------------------------------------------------
+        LOG_FATAL(LOG_BLOCKCHAIN)
+            << "Failure in block payment indexing, store is now corrupt: "
+            << ec.message();
+
+        // In the case of a store failure the server stops processing.
+        stop();
+        return;
+    }
+
+    validation_mutex_.unlock_low_priority();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+static size_t next_height(size_t top)
+{
+    return top == max_size_t ? 0 : top + 1u;
+}
+
+// private
+// The transaction filter is not persisted, so it is populated from the
+// confirmed chain after each start. The stealth and spend indexes are
+// persisted and continue from their committed heights. One block is indexed
+// per critical section, so this does not stall validation, and reorganization
+// may lower an index height. Reorganization extends the stealth and spend indexes
+// once each reaches the fork point, and each transaction write extends the
+// filter. The walk proceeds from the lowest of the index heights.
+void block_chain::populate_indexes()
+{
+    const auto filter = settings_.hash_filter_capacity != 0;
+    const auto spends = settings_.index_spends;
+    auto height = filter ? size_t(0) : max_size_t;
+    size_t top;
+
+    while (true)
+    {
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        validation_mutex_.lock_low_priority();
+
+        if (index_addresses_)
+            height = std::min(height, next_height(stealth_index_.top()));
+
+        if (spends)
+            height = std::min(height, next_height(spend_index_.height()));
+
+        if (stopped() || !confirmed_columns_.top(top))
+        {
+            validation_mutex_.unlock_low_priority();
+            //-----------------------------------------------------------------
+            return;
+        }
+
+        if (height > top)
+        {
+            validation_mutex_.unlock_low_priority();
+            //-----------------------------------------------------------------
+            break;
+        }
+
+        const auto block = get_block(height, false, false);
+
+        if (!block)
+        {
+            validation_mutex_.unlock_low_priority();
+            //-----------------------------------------------------------------
+            LOG_ERROR(LOG_BLOCKCHAIN)
+                << "Failure reading block for start indexing at " << height;
+            return;
+        }
+
+        if (index_addresses_ && next_height(stealth_index_.top()) == height &&
+            !populate_stealth(*block, height, top))
+        {
+            validation_mutex_.unlock_low_priority();
+            //-----------------------------------------------------------------
+            LOG_ERROR(LOG_BLOCKCHAIN)
+                << "Failure writing stealth index at " << height;
+            return;
+        }
+
+        if (spends && next_height(spend_index_.height()) == height &&
+            !populate_spends(*block, height, top))
+        {
+            validation_mutex_.unlock_low_priority();
+            //-----------------------------------------------------------------
+            LOG_ERROR(LOG_BLOCKCHAIN)
+                << "Failure writing spend index at " << height;
+            return;
+        }
+
+        if (filter)
+            index_filter(*block);
+
+        ++height;
+        validation_mutex_.unlock_low_priority();
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    if (index_addresses_)
+        LOG_INFO(LOG_BLOCKCHAIN)
+            << "Indexed " << stealth_index_.size()
+            << " stealth outputs to height " << top;
+
+    if (spends)
+        LOG_INFO(LOG_BLOCKCHAIN)
+            << "Indexed " << spend_index_.size()
+            << " spends to height " << top;
+
+    if (filter && populate_filter())
+    {
+        transaction_filter_primed_ = true;
+        LOG_INFO(LOG_BLOCKCHAIN)
+            << "Primed transaction filter to height " << top;
+    }
+}
+
+// private
+// Index the spends of the next block, committing at an interval and the top.
+// Guarded by the caller.
+bool block_chain::populate_spends(const chain::block& block, size_t height,
+    size_t top)
+{
+    if (!spend_index_.begin_write())
+        return false;
+
+    index_spends(block, height);
+
+    if (height == top || height % index_commit_interval == 0)
+        return spend_index_.end_write(height);
+
+    spend_index_.set_height(height);
+    return true;
+}
+
+// private
+// Candidate blocks above the fork point are stored but not confirmed. Blocks
+// written after start are added as written, so no critical section is
+// required. Unconfirmed transactions stored before start, outside of the
+// candidate chain, are not added (these may be requested again).
+bool block_chain::populate_filter()
+{
+    size_t top;
+
+    if (!candidate_columns_.top(top))
+        return false;
+
+    for (auto height = fork_point().height() + 1u; height <= top; ++height)
+    {
+        if (stopped())
+            return false;
+
+        // Candidate blocks that are not yet downloaded are not returned.
+        const auto block = get_block(height, false, true);
+
+        if (block)
+            index_filter(*block);
+    }
+
+    return true;
+}
+
+// private
+void block_chain::index_filter(const chain::block& block)
+{
+    for (const auto& tx: block.transactions())
+        transaction_filter_.add(tx.hash());
+}
+
+// private
+// Pop the rows of outgoing blocks and add those of incoming blocks, unless
+// population has not yet reached the fork point (it then continues).
+// The index is uncommitted while written, so an interruption is rebuilt.
+bool block_chain::index_stealth(size_t fork_height,
+    block_const_ptr_list_const_ptr incoming)
+{
+    const auto indexed = stealth_index_.top();
+
+    if (indexed == max_size_t || indexed < fork_height)
+        return true;
+
+    if (!stealth_index_.begin_write())
+        return false;
+
+    stealth_index_.remove(fork_height);
+    auto height = fork_height;
+
+    for (const auto block: *incoming)
+        index_stealth(*block, ++height);
+
+    return stealth_index_.end_write(height);
+}
+
+// private
+// Index the stealth outputs of the next block, committing at an interval and
+// the top. Guarded by the caller.
+bool block_chain::populate_stealth(const chain::block& block, size_t height,
+    size_t top)
+{
+    if (!stealth_index_.begin_write())
+        return false;
+
+    index_stealth(block, height);
+
+    if (height == top || height % index_commit_interval == 0)
+        return stealth_index_.end_write(height);
+
+    stealth_index_.set_top(height);
+    return true;
+}
+
+// private
+// Open the index, which is populated from its committed top in the
+// background. An uncommitted index (new or interrupted) is cleared and so is
+// rebuilt from genesis, during which stealth queries fail.
+bool block_chain::open_stealth()
+{
+    size_t top;
+
+    if (!stealth_index_.open() || !confirmed_columns_.top(top))
+        return false;
+
+    const auto indexed = stealth_index_.top();
+
+    // The store cannot be below a committed index, but if so it is rebuilt.
+    return (indexed != max_size_t && indexed <= top) ||
+        stealth_index_.clear();
+}
+
+// private
+// A stealth payment is an ephemeral key output followed by a payment output.
+void block_chain::index_stealth(const chain::block& block, size_t height)
+{
+    for (const auto& tx: block.transactions())
+    {
+        const auto& outputs = tx.outputs();
+
+        for (size_t index = 1; index < outputs.size(); ++index)
+        {
+            uint32_t prefix;
+            hash_digest ephemeral_key;
+            const auto& script = outputs[index - 1u].script();
+
+            if (!extract_ephemeral_key(ephemeral_key, script) ||
+                !to_stealth_prefix(prefix, script))
+                continue;
+
+            const auto address = outputs[index].address();
+
+            if (!address)
+                continue;
+
+            stealth_index_.add({ prefix, height, ephemeral_key,
+                address.hash(), tx.hash() });
+        }
+    }
+}
+
+// private
+void block_chain::index_transaction(transaction_const_ptr tx)
+{
+    if (!index_addresses_ || tx->metadata.existed)
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    // Indexing is asynchronous, but it is a store write, so it is batched.
+    validation_mutex_.lock_low_priority();
+
+    code ec;
+    if ((ec = begin_write()) || (ec = database_.index(*tx)) ||
+        (ec = commit_write(0, 0)))
+    {
+        abort_write(ec);
+        validation_mutex_.unlock_low_priority();
+        //---------------------------------------------------------------------
+        LOG_FATAL(LOG_BLOCKCHAIN)
+            << "Failure in transaction payment indexing, store is now corrupt: "
+            << ec.message();
+
+        // In the case of a store failure the server stops processing.
+        stop();
+        return;
+    }
+
+    validation_mutex_.unlock_low_priority();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+code block_chain::store(transaction_const_ptr tx)
+{
+    const auto state = tx->metadata.state;
+
+    if (!state)
+        return error::operation_failed;
+
+    // Clear chain state for store, index_transaction and notify.
+    tx->metadata.state.reset();
+
+    // The filter is extended before the write, so a miss is never stale.
+    transaction_filter_.add(tx->hash());
+
+    code ec;
+    if ((ec = begin_write()) ||
+        (ec = database_.store(*tx, state->enabled_forks())))
+        return abort_write(ec);
+
+    // Payment indexing is asynchronous, after tx is stored. Therefore
+    // it is possible for a tx to be in any existing state and not be indexed.
+    if (index_addresses_ && !tx->metadata.existed)
+        dispatch_.concurrent(&block_chain::index_transaction, this, tx);
+
+    notify(tx);
+
+    // Restore chain state for the transaction cache.
+    tx->metadata.state = state;
+    transaction_cache_.add(tx, transaction_result::unconfirmed,
+        state->height());
+    return commit_write(0, 0);
+}
+
+code block_chain::reorganize(const config::checkpoint& fork,
+    header_const_ptr_list_const_ptr incoming)
+{
+    if (incoming->empty())
+        return error::operation_failed;
+
+    const auto top = incoming->back();
+    const auto top_state = top->metadata.state;
+
+    if (!top_state)
+        return error::operation_failed;
+
+    // TODO: if leave uncleared do not need header.median_time_past.
+    ////// Clear incoming chain state for reorganize and notify.
+    ////std::for_each(incoming->begin(), incoming->end(),
+    ////    [](header_const_ptr header) { header->metadata.state.reset(); });
+
+    code ec;
+    auto fork_height = fork.height();
+    const auto outgoing = std::make_shared<header_const_ptr_list>();
+
+    // This unmarks candidate txs and spent outputs (may have been validated).
+    if ((ec = begin_write()) ||
+        (ec = database_.reorganize(fork, incoming, outgoing)))
+        return abort_write(ec);
+
+    // Outgoing candidates may remain confirmed, so refresh confirmed states.
+    if (!index_columns(fork_height + 1u, true))
+        return abort_write(error::operation_failed);
+
+    index_states(fork_height + 1u, max_size_t, false);
+
+    // Don't add outgoing because only populated after reorganize and at that
+    // point the headers are no longer indexed (populator requires indexation).
+    if (!incoming->empty())
+    {
+        header_pool_.remove(incoming);
+        header_pool_.prune(top_state->height());
+    }
+
+    // If confirmed fork point is above candidate fork point then lower it.
+    if (fork_point().height() > fork_height)
+    {
+        // Set new fork point and recompute confirmed work from it.
+        set_fork_point(fork);
+        set_confirmed_work();
+
+        // When fork point is lowered the top valid candidate is at fork point.
+        auto top_valid = chain_state_populator_.populate(fork_height, true);
+        set_top_valid_candidate_state(top_valid);
+        set_candidate_work(0);
+    }
+
+    set_top_candidate_state(top_state);
+    notify(fork_height, incoming, outgoing);
+    return commit_write(0, 0);
+}
+
+code block_chain::update(block_const_ptr block, size_t height)
+{
+    code error_code;
+    const auto& metadata = block->header().metadata;
+
+    // Downloads are not organized under the validation mutex, so that they
+    // are not serialized behind validation. The columns lock internally.
+    if (!metadata.error)
+    {
+        // The filter is extended before the write, so a miss is never stale.
+        index_filter(*block);
+
+        // Store or connect each transaction and set tx link metadata.
+        if ((error_code = begin_write()) ||
+            (error_code = database_.update(*block, height)))
+            return abort_write(error_code);
+
+        // The header may have been reorganized out since the download.
+        const auto result = database_.blocks().get(block->hash());
+
+        if (result)
+            candidate_columns_.set_block(block->hash(), height,
+                result.state(), result.transaction_count() != 0);
+
+        // The block is durable once its write group is committed.
+        error_code = commit_write(1, block->serialized_size(true));
+    }
+    else if (metadata.validated)
+    {
+        // Set block validation error state and error code.
+        // Never set valid on update as validation handling would be skipped.
+        error_code = invalidate(block->header(), metadata.error);
+    }
+
+    return error_code;
+}
+
+code block_chain::invalidate(const chain::header& header, const code& error)
+{
+    code ec;
+
+    // Mark candidate header as invalid.
+    if ((ec = begin_write()) || (ec = database_.invalidate(header, error)))
+        return abort_write(ec);
+
+    index_state(header.hash());
+    return commit_write(0, 0);
+}
+
+// Mark candidate block and descendants as invalid and pop them.
+code block_chain::invalidate(block_const_ptr block, size_t block_height)
+{
+    const auto& header = block->header();
+    BITCOIN_ASSERT(header.metadata.error);
+
+    size_t top;
+    if (!get_top_height(top, true))
+        return error::operation_failed;
+
+    hash_digest fork_hash;
+    const auto fork_height = block_height - 1u;
+    if (!get_block_hash(fork_hash, fork_height, true))
+        return error::operation_failed;
+
+    code ec;
+    const config::checkpoint fork{ fork_hash, fork_height };
+    const auto outgoing = std::make_shared<header_const_ptr_list>();
+    const auto incoming = std::make_shared<header_const_ptr_list>();
 
     // Copy first invalid candidate header to outgoing.
     outgoing->push_back(std::make_shared<const message::header>(header));
@@ -518,14 +1180,18 @@ code block_chain::invalidate(block_const_ptr block, size_t block_height)
             return ec;
 
     // This should not have to unmark because none were ever valid.
-    if ((ec = database_.reorganize(fork, incoming, outgoing)))
-        return ec;
+    if ((ec = begin_write()) ||
+        (ec = database_.reorganize(fork, incoming, outgoing)))
+        return abort_write(ec);
+
+    if (!index_columns(fork_height + 1u, true))
+        return abort_write(error::operation_failed);
 
     // Lower top candidate state to that of the top valid (previous header).
     set_top_candidate_state(top_valid_candidate_state());
 
     notify(fork_height, incoming, outgoing);
-    return ec;
+    return commit_write(0, 0);
 }
 
 // Mark candidate block as valid and mark candidate-spent outputs.
@@ -536,19 +1202,25 @@ code block_chain::candidate(block_const_ptr block)
     BITCOIN_ASSERT(!header.metadata.error);
 
     // Mark candidate block valid, txs and outputs spent by them as candidate.
-    if ((ec = database_.candidate(*block)))
-        return ec;
+    if ((ec = begin_write()) || (ec = database_.candidate(*block)))
+        return abort_write(ec);
+
+    const auto height = header.metadata.state->height();
+    index_states(height, height, true);
 
     // Advance the top valid candidate state and candidate work.
     set_top_valid_candidate_state(header.metadata.state);
     set_candidate_work(candidate_work() + header.proof());
 
+    // Validation no longer writes the block, so it may be shared by queries.
+    block_cache_.add(block);
+
     // Payment indexing is asynchronous, after block is candidate. Therefore
     // it is possible for a block to be in any valid state and not be indexed.
     if (index_addresses_)
         dispatch_.concurrent(&block_chain::index_block, this, block);
 
-    return ec;
+    return commit_write(0, 0);
 }
 
 // Reorganize this stronger candidate branch into confirmed chain.
@@ -570,7 +1242,7 @@ code block_chain::reorganize(block_const_ptr_list_const_ptr branch_cache,
     const auto outgoing = std::make_shared<block_const_ptr_list>();
     const auto incoming = std::make_shared<block_const_ptr_list>();
 
-    // Get all missing incoming candidates with chain state (expensive reads).
+    // Get all missing incoming candidates with chain state (cached reads).
     for (auto height = fork.height() + 1u; height < branch_height; ++height)
     {
         const auto block = get_block(height, true, true);
@@ -592,9 +1264,32 @@ code block_chain::reorganize(block_const_ptr_list_const_ptr branch_cache,
         incoming->push_back(block);
     }
 
+    // Publish an odd epoch while the confirmed chain is being written.
+    begin_confirmed_write();
+
     // This unmarks candidate txs and spent outputs (because confirmed).
-    if ((ec = database_.reorganize(fork, incoming, outgoing)))
-        return ec;
+    if (!(ec = begin_write()))
+        ec = database_.reorganize(fork, incoming, outgoing);
+
+    // Reorganized candidates are now also confirmed, so refresh their states.
+    const auto indexed = !ec && index_columns(fork.height() + 1u, false);
+    end_confirmed_write();
+
+    if (ec)
+        return abort_write(ec);
+
+    if (!indexed)
+        return abort_write(error::operation_failed);
+
+    index_states(fork.height() + 1u, top_state->height(), true);
+    cache_transactions(fork.height(), incoming, outgoing);
+
+    if (settings_.index_spends &&
+        !index_spends(fork.height(), incoming, outgoing))
+        return abort_write(error::operation_failed);
+
+    if (index_addresses_ && !index_stealth(fork.height(), incoming))
+        return abort_write(error::operation_failed);
 
     // Top valid candidate is now top confirmed and the new fork point.
     set_fork_point({ top->hash(), top_state->height() });
@@ -603,12 +1298,83 @@ code block_chain::reorganize(block_const_ptr_list_const_ptr branch_cache,
     set_next_confirmed_state(top_state);
     notify(fork.height(), incoming, outgoing);
 
-    // Restore chain state for last_block_ cache.
-    top->header().metadata.state = top_state;
-    last_block_.store(top);
+    return commit_write(0, 0);
+}
+
+// private
+// Grouped writes are flushed once per group, instead of once per write. The
+// store flush lock is set by the first write of a group and cleared once the
+// group is flushed, so a crash between groups leaves the store consistent.
+// Store writes other than update are made under the validation mutex.
+code block_chain::begin_write()
+{
+    if (!write_batch_.begin())
+        return error::success;
+
+    if (!database_.flush_lock())
+        return error::operation_failed;
+
+    // The time bound is enforced even if there are no more writes.
+    if (settings_.flush_batch_milliseconds != 0)
+        flush_timer_->start(std::bind(&block_chain::handle_flush_timer,
+            this, _1));
+
+    return error::success;
+}
+
+// private
+// Each block is counted once, when its transactions are written (update).
+code block_chain::commit_write(size_t blocks, size_t bytes)
+{
+    if (!write_batch_.enabled() || !write_batch_.add(blocks, bytes))
+        return error::success;
+
+    return end_write();
+}
+
+// private
+code block_chain::end_write()
+{
+    flush_timer_->stop();
+    return database_.flush() && database_.flush_unlock() ? error::success :
+        error::operation_failed;
+}
+
+// private
+// A failed write closes its group without clearing the store flush lock, so
+// the store is not marked consistent by a later flush (timer or close).
+code block_chain::abort_write(const code& ec)
+{
+    if (write_batch_.reset())
+        flush_timer_->stop();
+
     return ec;
 }
 
+// private
+void block_chain::handle_flush_timer(const code& ec)
+{
+    if (ec || stopped())
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    validation_mutex_.lock_high_priority();
+    const auto result = write_batch_.reset() ? end_write() : error::success;
+    validation_mutex_.unlock_high_priority();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (result)
+    {
+        LOG_FATAL(LOG_BLOCKCHAIN)
+            << "Failure in write group flush, store is now corrupt: "
+            << result.message();
+
+        // In the case of a store failure the server stops processing.
+        stop();
+    }
+}
+
 // Properties.
 // ----------------------------------------------------------------------------
 
@@ -656,17 +1422,31 @@ bool block_chain::set_fork_point()
 
     hash_digest candidate_hash;
     hash_digest confirmed_hash;
-    auto common = std::min(candidate_height, confirmed_height);
 
-    // The loop must at least terminate on the genesis block.
+    // The search must at least terminate on the genesis block.
     BITCOIN_ASSERT(get_block_hash(candidate_hash, 0, true));
     BITCOIN_ASSERT(get_block_hash(confirmed_hash, 0, false));
     BITCOIN_ASSERT(candidate_hash == confirmed_hash);
 
-    while (get_block_hash(candidate_hash, common, true) &&
-        get_block_hash(confirmed_hash, common, false) &&
-        candidate_hash != confirmed_hash)
-        --common;
+    // The indexes are identical up to the fork point and differ above it, as
+    // each hash commits to its parent. So binary search for the last match.
+    size_t common = 0;
+    auto above = std::min(candidate_height, confirmed_height) + 1u;
+
+    while (above - common > 1u)
+    {
+        const auto middle = common + (above - common) / 2u;
+
+        if (get_block_hash(candidate_hash, middle, true) &&
+            get_block_hash(confirmed_hash, middle, false) &&
+            candidate_hash == confirmed_hash)
+            common = middle;
+        else
+            above = middle;
+    }
+
+    if (!get_block_hash(confirmed_hash, common, false))
+        return false;
 
     set_fork_point({ confirmed_hash, common });
     return true;
@@ -708,16 +1488,27 @@ bool block_chain::set_top_candidate_state()
 // private.
 bool block_chain::set_top_valid_candidate_state()
 {
-    size_t height;
-    if (!get_top_height(height, true))
+    size_t top;
+    if (!get_top_height(top, true))
         return false;
 
-    // The loop must at least terminate on the genesis block.
+    // The search must at least terminate on the genesis block.
     BITCOIN_ASSERT(is_valid(get_block_state(0, true)));
 
-    // Loop from top to genesis in the candidate index.
-    while (!is_valid(get_block_state(height, true)))
-        --height;
+    // Candidates are validated in height order, so valid candidates are a
+    // prefix of the candidate index. So binary search for the last valid.
+    size_t height = 0;
+    auto above = top + 1u;
+
+    while (above - height > 1u)
+    {
+        const auto middle = height + (above - height) / 2u;
+
+        if (is_valid(get_block_state(middle, true)))
+            height = middle;
+        else
+            above = middle;
+    }
 
     const auto state = chain_state_populator_.populate(height, true);
     set_top_valid_candidate_state(state);
@@ -841,24 +1632,69 @@ bool block_chain::start()
     if (!database_.open())
         return false;
 
+    // Store settings are not overridden, so writes are grouped only if the
+    // store does not flush each write (which is the stronger guarantee).
+    if (settings_.flush_batch_blocks != 0 && !write_batch_.enabled())
+        LOG_WARNING(LOG_BLOCKCHAIN)
+            << "Write groups are ignored, as the store flushes each write.";
+
+    // Without flushed writes the store sets its flush lock for the session.
+    // Grouped writes instead set it for each group, and none is yet open.
+    if (write_batch_.enabled() && !database_.flush_unlock())
+        return false;
+
+    // Mirror the store indexes before any chain state is populated.
+    // This load is linear in the index heights, and bounds start time. The
+    // searches below are logarithmic only over the loaded columns.
+    if (!index_columns(0, true) || !index_columns(0, false))
+        return false;
+
+    if (settings_.index_spends && !open_spends())
+        return false;
+
+    if (index_addresses_ && !open_stealth())
+        return false;
+
     block_subscriber_->start();
     header_subscriber_->start();
     transaction_subscriber_->start();
 
-    return set_fork_point()
-        && set_top_candidate_state()
-        && set_top_valid_candidate_state()
-        && set_next_confirmed_state()
-        && set_candidate_work()
-        && set_confirmed_work()
-        && block_organizer_.start()
-        && header_organizer_.start()
-        && transaction_organizer_.start();
+    // Ready heights of candidates popped by header reorganization are cleared.
+    subscribe_headers(std::bind(&block_organizer::handle_reorganized,
+        &block_organizer_, _1, _2, _3, _4));
+
+    if (!set_fork_point() ||
+        !set_top_candidate_state() ||
+        !set_top_valid_candidate_state() ||
+        !set_next_confirmed_state() ||
+        !set_candidate_work() ||
+        !set_confirmed_work() ||
+        !block_organizer_.start() ||
+        !header_organizer_.start() ||
+        !transaction_organizer_.start() ||
+        !prime_candidates())
+        return false;
+
+    // Stealth and spend queries fail until this reaches the top confirmed
+    // block, and inventory is filtered against the store until primed.
+    if (index_addresses_ || settings_.index_spends ||
+        settings_.hash_filter_capacity != 0)
+        dispatch_.concurrent(&block_chain::populate_indexes, this);
+
+    return true;
 }
 
 bool block_chain::stop()
 {
     stopped_ = true;
+    flush_timer_->stop();
+
+    // New queries are rejected, and this waits for accepted queries to
+    // complete (the store is still open), so that every handler is invoked.
+    // Only then may the query pool be shut down without losing queued work.
+    // A stop from a query handler does not wait, and close then completes it.
+    if (query_executor_.stop())
+        query_pool_.shutdown();
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
@@ -892,7 +1728,13 @@ bool block_chain::close()
 {
     const auto result = stop();
     priority_pool_.join();
-    return result && database_.close();
+    query_pool_.join();
+
+    // Commit the open write group, if any.
+    const auto committed = !write_batch_.reset() || !end_write();
+    const auto spends = !settings_.index_spends || spend_index_.close();
+    const auto stealth = !index_addresses_ || stealth_index_.close();
+    return result && committed && spends && stealth && database_.close();
 }
 
 block_chain::~block_chain()
@@ -907,20 +1749,82 @@ block_chain::~block_chain()
 bool block_chain::get_transactions(transaction::list& out_transactions,
     const database::block_result& result, bool witness) const
 {
-    out_transactions.reserve(result.transaction_count());
-    const auto& tx_store = database_.transactions();
+    std::vector<file_offset> offsets;
+    offsets.reserve(result.transaction_count());
 
     for (const auto offset: result)
+        offsets.push_back(offset);
+
+    return get_transactions(out_transactions, std::move(offsets), witness);
+}
+
+// private
+bool block_chain::get_transactions(transaction::list& out_transactions,
+    std::vector<file_offset>&& offsets, bool witness) const
+{
+    const auto count = offsets.size();
+    const auto buckets = std::min(priority_.size(),
+        count / transactions_per_reader);
+
+    // Small sets are read serially, as dispatch would cost more than saved.
+    if (buckets < 2u)
     {
-        const auto result = tx_store.get(offset);
+        out_transactions.reserve(count);
+        const auto& tx_store = database_.transactions();
 
-        if (!result)
-            return false;
+        for (const auto offset: offsets)
+        {
+            const auto result = tx_store.get(offset);
+
+            if (!result)
+                return false;
+
+            out_transactions.push_back(result.transaction(witness));
+        }
 
-        out_transactions.push_back(result.transaction(witness));
+        return true;
     }
 
-    return true;
+    const auto reader = std::make_shared<transaction_reader>();
+    reader->offsets = std::move(offsets);
+
+    // Transactions are deserialized in place, in any order.
+    out_transactions.resize(count);
+    reader->transactions = &out_transactions;
+    reader->witness = witness;
+    reader->next = 0;
+    reader->done = 0;
+    reader->failed = false;
+    auto complete = reader->complete.get_future();
+
+    for (size_t bucket = 1; bucket < buckets; ++bucket)
+        priority_.concurrent(&block_chain::read_transactions, this, reader);
+
+    // The caller also reads, so it never waits on a read that has not started.
+    read_transactions(reader);
+    complete.wait();
+    return !reader->failed;
+}
+
+// private
+void block_chain::read_transactions(transaction_reader_ptr reader) const
+{
+    const auto count = reader->offsets.size();
+    const auto& tx_store = database_.transactions();
+    const auto transactions = reader->transactions;
+
+    for (auto index = reader->next++; index < count; index = reader->next++)
+    {
+        const auto result = tx_store.get(reader->offsets[index]);
+
+        if (result)
+            (*transactions)[index] = result.transaction(reader->witness);
+        else
+            reader->failed = true;
+
+        if (++reader->done == count)
+            reader->complete.set_value();
+    }
 }
 
 // private
@@ -943,8 +1847,295 @@ bool block_chain::get_transaction_hashes(hash_list& out_hashes,
     return true;
 }
 
-void block_chain::fetch_block(size_t height, bool witness,
-    block_fetch_handler handler) const
+// private
+// Serialize from the store, without constructing a block message. Store
+// transaction slabs are not wire serialized (outputs precede inputs and carry
+// spender metadata), so each transaction is deserialized and then written.
+// TODO: transcode store slabs directly, which requires a store slab reader.
+bool block_chain::get_block_data(data_chunk& out_data,
+    const database::block_result& result, bool witness) const
+{
+    transaction::list txs;
+
+    if (!get_transactions(txs, result, witness))
+        return false;
+
+    const auto header = result.header();
+    auto size = header.serialized_size() + variable_uint_size(txs.size());
+
+    for (const auto& tx: txs)
+        size += tx.serialized_size(true, witness);
+
+    // Size the buffer once, each transaction is written in place.
+    out_data.reserve(size);
+    data_sink ostream(out_data);
+    ostream_writer sink(ostream);
+    header.to_data(sink);
+    sink.write_size_little_endian(txs.size());
+
+    for (const auto& tx: txs)
+        tx.to_data(sink, true, witness);
+
+    ostream.flush();
+    BITCOIN_ASSERT(out_data.size() == size);
+    return true;
+}
+
+void block_chain::fetch_block(size_t height, bool witness,
+    block_fetch_handler handler) const
+{
+    if (stopped())
+    {
+        handler(error::service_stopped, nullptr, 0);
+        return;
+    }
+
+    const auto query = [=]()
+    {
+        block_const_ptr block;
+        const auto ec = get_block(block, height, witness);
+        handler(ec, block, ec ? 0 : height);
+    };
+
+    if (!query_executor_.execute(block_query, query))
+        handler(error::oversubscribed, nullptr, 0);
+}
+
+// private
+code block_chain::get_block(block_const_ptr& out_block, size_t height,
+    bool witness) const
+{
+    hash_digest hash;
+
+    // Try the cache first, the cached block must be confirmed at the height.
+    // Cached blocks carry witness data, so only serve them when requested.
+    if (witness && get_block_hash(hash, height, false))
+    {
+        out_block = block_cache_.get(hash);
+
+        if (out_block)
+            return error::success;
+    }
+
+    const auto result = database_.blocks().get(height, false);
+
+    if (!result)
+        return error::not_found;
+
+    transaction::list txs;
+    BITCOIN_ASSERT(result.height() == height);
+
+    if (!get_transactions(txs, result, witness))
+        return error::operation_failed;
+
+    // Use non-const header copy to obtain move construction for txs.
+    auto header = result.header();
+    out_block = std::make_shared<const block>(std::move(header),
+        std::move(txs));
+    return error::success;
+}
+
+// Blocks are read ahead in parallel and delivered in height order. A stream
+// ends with a null block, or when the handler returns false.
+void block_chain::fetch_blocks(size_t from_height, size_t to_height,
+    bool witness, block_stream_handler handler) const
+{
+    if (stopped())
+    {
+        handler(error::service_stopped, nullptr, from_height);
+        return;
+    }
+
+    if (from_height > to_height)
+    {
+        handler(error::success, nullptr, from_height);
+        return;
+    }
+
+    // Queries execute inline without query threads, so there is no read-ahead.
+    const auto count = to_height - from_height + 1u;
+    const size_t read_ahead = settings_.query_threads == 0 ? 0 :
+        std::min(size_t(settings_.block_read_ahead), count);
+
+    // Without read-ahead the range is read serially as a query.
+    if (read_ahead == 0)
+    {
+        const auto query = [=]()
+        {
+            for (auto height = from_height; height <= to_height; ++height)
+            {
+                block_const_ptr block;
+                code ec(error::service_stopped);
+
+                if (!stopped())
+                    ec = get_block(block, height, witness);
+
+                if (ec)
+                {
+                    handler(ec, nullptr, height);
+                    return;
+                }
+
+                if (!handler(error::success, block, height))
+                    return;
+            }
+
+            handler(error::success, nullptr, to_height + 1u);
+        };
+
+        if (!query_executor_.execute(block_query, query))
+            handler(error::oversubscribed, nullptr, from_height);
+
+        return;
+    }
+
+    const auto stream = std::make_shared<block_stream>();
+    stream->to_height = to_height;
+    stream->witness = witness;
+    stream->handler = handler;
+    stream->next_read = from_height + read_ahead;
+    stream->next_deliver = from_height;
+    stream->delivering = false;
+    stream->stopped = false;
+
+    for (auto height = from_height; height < stream->next_read; ++height)
+        submit_stream(stream, height);
+}
+
+// private
+// Each read is a block query, so reads are limited with all other queries.
+// A rejected read is delivered as a failure at its height, ending the stream.
+void block_chain::submit_stream(block_stream_ptr stream, size_t height) const
+{
+    const auto query = [=]()
+    {
+        block_const_ptr block;
+        code ec(error::service_stopped);
+
+        if (!stopped())
+            ec = get_block(block, height, stream->witness);
+
+        deliver_stream(stream, height, ec, block);
+    };
+
+    if (!query_executor_.execute(block_query, query))
+        deliver_stream(stream, height, stopped() ? error::service_stopped :
+            error::oversubscribed, nullptr);
+}
+
+// private
+// The reader that completes the next height delivers all ready blocks in
+// order, and each delivery submits the read of one more height.
+void block_chain::deliver_stream(block_stream_ptr stream, size_t height,
+    code ec, block_const_ptr block) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    stream->mutex.lock();
+
+    stream->ready.emplace(height, std::make_pair(ec, block));
+
+    if (stream->delivering || stream->stopped)
+    {
+        stream->mutex.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    stream->delivering = true;
+
+    for (auto it = stream->ready.find(stream->next_deliver);
+        it != stream->ready.end() && !stream->stopped;
+        it = stream->ready.find(stream->next_deliver))
+    {
+        const auto next = stream->next_deliver++;
+        ec = it->second.first;
+        block = it->second.second;
+        stream->ready.erase(it);
+
+        const auto read = !ec && stream->next_read <= stream->to_height ?
+            stream->next_read++ : max_size_t;
+
+        stream->mutex.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        // Submitted outside of the lock, as a rejection delivers inline.
+        if (read != max_size_t)
+            submit_stream(stream, read);
+
+        auto more = !ec && stream->handler(error::success, block, next);
+
+        if (ec)
+            stream->handler(ec, nullptr, next);
+        else if (more && next == stream->to_height)
+        {
+            stream->handler(error::success, nullptr, next + 1u);
+            more = false;
+        }
+
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        stream->mutex.lock();
+        stream->stopped = !more;
+    }
+
+    stream->delivering = false;
+    stream->mutex.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void block_chain::fetch_block(const hash_digest& hash, bool witness,
+    block_fetch_handler handler) const
+{
+    if (stopped())
+    {
+        handler(error::service_stopped, nullptr, 0);
+        return;
+    }
+
+    const auto query = [=]()
+    {
+        size_t height;
+        block_const_ptr block;
+        const auto ec = get_block(block, height, hash, witness);
+        handler(ec, block, ec ? 0 : height);
+    };
+
+    if (!query_executor_.execute(block_query, query))
+        handler(error::oversubscribed, nullptr, 0);
+}
+
+// private
+code block_chain::get_block(block_const_ptr& out_block, size_t& out_height,
+    const hash_digest& hash, bool witness) const
+{
+    // Try the cache first, the height is resolved from the indexes.
+    // Cached blocks carry witness data, so only serve them when requested.
+    out_block = witness ? block_cache_.get(hash) : nullptr;
+
+    if (out_block && get_height(out_height, hash))
+        return error::success;
+
+    const auto result = database_.blocks().get(hash);
+
+    if (!result)
+        return error::not_found;
+
+    transaction::list txs;
+
+    if (!get_transactions(txs, result, witness))
+        return error::operation_failed;
+
+    // Use non-const header copy to obtain move construction for txs.
+    auto header = result.header();
+    out_block = std::make_shared<const block>(std::move(header),
+        std::move(txs));
+    out_height = result.height();
+    return error::success;
+}
+
+void block_chain::fetch_block_data(size_t height, bool witness,
+    block_data_fetch_handler handler) const
 {
     if (stopped())
     {
@@ -952,42 +2143,51 @@ void block_chain::fetch_block(size_t height, bool witness,
         return;
     }
 
-    const auto cached = last_block_.load();
-
-    // Try the cached block first.
-    if (cached && cached->header().metadata.state &&
-        cached->header().metadata.state->height() == height)
+    const auto query = [=]()
     {
-        handler(error::success, cached, height);
-        return;
-    }
+        hash_digest hash;
 
-    const auto result = database_.blocks().get(height, false);
+        // Try the cache first, the cached block must be confirmed at the
+        // height. A cached block is serialized from memory (no store read).
+        if (get_block_hash(hash, height, false))
+        {
+            const auto cached = block_cache_.get(hash);
+
+            if (cached)
+            {
+                const auto data = std::make_shared<const data_chunk>(
+                    cached->to_data(witness));
+                handler(error::success, data, height);
+                return;
+            }
+        }
 
-    if (!result)
-    {
-        handler(error::not_found, nullptr, 0);
-        return;
-    }
+        const auto result = database_.blocks().get(height, false);
 
-    transaction::list txs;
-    BITCOIN_ASSERT(result.height() == height);
+        if (!result)
+        {
+            handler(error::not_found, nullptr, 0);
+            return;
+        }
 
-    if (!get_transactions(txs, result, witness))
-    {
-        handler(error::operation_failed, nullptr, 0);
-        return;
-    }
+        const auto data = std::make_shared<data_chunk>();
+        BITCOIN_ASSERT(result.height() == height);
 
-    // Use non-const header copy to obtain move construction for txs.
-    auto header = result.header();
-    const auto message = std::make_shared<const block>(std::move(header),
-        std::move(txs));
-    handler(error::success, message, height);
+        if (!get_block_data(*data, result, witness))
+        {
+            handler(error::operation_failed, nullptr, 0);
+            return;
+        }
+
+        handler(error::success, data, height);
+    };
+
+    if (!query_executor_.execute(block_query, query))
+        handler(error::oversubscribed, nullptr, 0);
 }
 
-void block_chain::fetch_block(const hash_digest& hash, bool witness,
-    block_fetch_handler handler) const
+void block_chain::fetch_block_data(const hash_digest& hash, bool witness,
+    block_data_fetch_handler handler) const
 {
     if (stopped())
     {
@@ -995,37 +2195,42 @@ void block_chain::fetch_block(const hash_digest& hash, bool witness,
         return;
     }
 
-    const auto cached = last_block_.load();
-
-    // Try the cached block first.
-    if (cached && cached->header().metadata.state && cached->hash() == hash)
+    const auto query = [=]()
     {
-        const auto height = cached->header().metadata.state->height();
-        handler(error::success, cached, height);
-        return;
-    }
+        size_t height;
+        const auto cached = block_cache_.get(hash);
 
-    const auto result = database_.blocks().get(hash);
+        // Try the cache first, the height is resolved from the indexes.
+        // A cached block is serialized from memory (no store read).
+        if (cached && get_height(height, hash))
+        {
+            const auto data = std::make_shared<const data_chunk>(
+                cached->to_data(witness));
+            handler(error::success, data, height);
+            return;
+        }
 
-    if (!result)
-    {
-        handler(error::not_found, nullptr, 0);
-        return;
-    }
+        const auto result = database_.blocks().get(hash);
 
-    transaction::list txs;
+        if (!result)
+        {
+            handler(error::not_found, nullptr, 0);
+            return;
+        }
 
-    if (!get_transactions(txs, result, witness))
-    {
-        handler(error::operation_failed, nullptr, 0);
-        return;
-    }
+        const auto data = std::make_shared<data_chunk>();
 
-    // Use non-const header copy to obtain move construction for txs.
-    auto header = result.header();
-    const auto message = std::make_shared<const block>(std::move(header),
-        std::move(txs));
-    handler(error::success, message, result.height());
+        if (!get_block_data(*data, result, witness))
+        {
+            handler(error::operation_failed, nullptr, 0);
+            return;
+        }
+
+        handler(error::success, data, result.height());
+    };
+
+    if (!query_executor_.execute(block_query, query))
+        handler(error::oversubscribed, nullptr, 0);
 }
 
 void block_chain::fetch_block_header(size_t height,
@@ -1132,18 +2337,213 @@ void block_chain::fetch_merkle_block(const hash_digest& hash,
     handler(error::success, merkle, result.height());
 }
 
-void block_chain::fetch_compact_block(size_t ,
-    compact_block_fetch_handler handler) const
+void block_chain::fetch_merkle_block(size_t height, bloom_filter::ptr filter,
+    filtered_block_fetch_handler handler) const
+{
+    if (stopped())
+    {
+        handler(error::service_stopped, nullptr, {}, 0);
+        return;
+    }
+
+    const auto query = [=]()
+    {
+        block_const_ptr block;
+        const auto ec = get_block(block, height, false);
+
+        if (ec)
+        {
+            handler(ec, nullptr, {}, 0);
+            return;
+        }
+
+        transaction_const_ptr_list matched;
+        const auto merkle = filter_block(matched, *block, *filter);
+        handler(error::success, merkle, std::move(matched), height);
+    };
+
+    if (!query_executor_.execute(block_query, query))
+        handler(error::oversubscribed, nullptr, {}, 0);
+}
+
+void block_chain::fetch_merkle_block(const hash_digest& hash,
+    bloom_filter::ptr filter, filtered_block_fetch_handler handler) const
+{
+    if (stopped())
+    {
+        handler(error::service_stopped, nullptr, {}, 0);
+        return;
+    }
+
+    const auto query = [=]()
+    {
+        size_t height;
+        block_const_ptr block;
+        const auto ec = get_block(block, height, hash, false);
+
+        if (ec)
+        {
+            handler(ec, nullptr, {}, 0);
+            return;
+        }
+
+        transaction_const_ptr_list matched;
+        const auto merkle = filter_block(matched, *block, *filter);
+        handler(error::success, merkle, std::move(matched), height);
+    };
+
+    if (!query_executor_.execute(block_query, query))
+        handler(error::oversubscribed, nullptr, {}, 0);
+}
+
+// private
+// Transactions are matched in block order, as a match may update the filter
+// for the transactions that follow it in the block.
+merkle_block_ptr block_chain::filter_block(
+    transaction_const_ptr_list& out_matched, const chain::block& block,
+    bloom_filter& filter)
 {
-    // TODO: implement compact blocks.
-    handler(error::not_implemented, {}, 0);
+    const auto& txs = block.transactions();
+    hash_list hashes;
+    hashes.reserve(txs.size());
+    std::vector<bool> matches;
+    matches.reserve(txs.size());
+
+    for (const auto& tx: txs)
+    {
+        const auto matched = filter.match(tx);
+        hashes.push_back(tx.hash());
+        matches.push_back(matched);
+
+        if (matched)
+            out_matched.push_back(std::make_shared<const transaction>(tx));
+    }
+
+    const partial_merkle_tree tree(hashes, matches);
+    return std::make_shared<merkle_block>(block.header(), txs.size(),
+        tree.hashes(), tree.flags());
 }
 
-void block_chain::fetch_compact_block(const hash_digest& ,
+void block_chain::fetch_compact_block(size_t height, uint64_t version,
     compact_block_fetch_handler handler) const
 {
-    // TODO: implement compact blocks.
-    handler(error::not_implemented, {}, 0);
+    if (stopped())
+    {
+        handler(error::service_stopped, nullptr, 0);
+        return;
+    }
+
+    // BIP152 defines version 1 (txid short ids) and 2 (wtxid short ids).
+    if (version != 1 && version != 2)
+    {
+        handler(error::operation_failed, nullptr, 0);
+        return;
+    }
+
+    const auto query = [=]()
+    {
+        block_const_ptr block;
+        const auto ec = get_block(block, height, true);
+
+        if (ec)
+        {
+            handler(ec, nullptr, 0);
+            return;
+        }
+
+        handler(error::success, get_compact_block(block, version), height);
+    };
+
+    if (!query_executor_.execute(block_query, query))
+        handler(error::oversubscribed, nullptr, 0);
+}
+
+void block_chain::fetch_compact_block(const hash_digest& hash,
+    uint64_t version, compact_block_fetch_handler handler) const
+{
+    if (stopped())
+    {
+        handler(error::service_stopped, nullptr, 0);
+        return;
+    }
+
+    // BIP152 defines version 1 (txid short ids) and 2 (wtxid short ids).
+    if (version != 1 && version != 2)
+    {
+        handler(error::operation_failed, nullptr, 0);
+        return;
+    }
+
+    const auto query = [=]()
+    {
+        size_t height;
+        block_const_ptr block;
+        const auto ec = get_block(block, height, hash, true);
+
+        if (ec)
+        {
+            handler(ec, nullptr, 0);
+            return;
+        }
+
+        handler(error::success, get_compact_block(block, version), height);
+    };
+
+    if (!query_executor_.execute(block_query, query))
+        handler(error::oversubscribed, nullptr, 0);
+}
+
+// private
+// A compact block is cached with its block, so that the short ids of a new
+// block are computed once for all of the peers that request it (BIP152).
+compact_block_ptr block_chain::get_compact_block(block_const_ptr block,
+    uint64_t version) const
+{
+    const auto hash = block->hash();
+    auto compact = block_cache_.get_compact(hash, version);
+
+    if (compact)
+        return compact;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    nonce_mutex_.lock();
+    const uint64_t nonce = nonce_generator_();
+    nonce_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    const auto& header = block->header();
+
+    // The siphash key is the first half of sha256(header || nonce).
+    const auto digest = sha256_hash(build_chunk({ header.to_data(),
+        to_little_endian(nonce) }));
+    half_hash half;
+    std::copy_n(digest.begin(), half.size(), half.begin());
+    const auto key = to_siphash_key(half);
+
+    const auto& txs = block->transactions();
+    BITCOIN_ASSERT(!txs.empty());
+    mini_hash_list short_ids;
+    short_ids.reserve(txs.size());
+
+    // Short ids are the low six bytes of the siphash of each txid (version 1)
+    // or wtxid (version 2).
+    const auto witness = (version == 2);
+
+    for (auto tx = std::next(txs.begin()); tx != txs.end(); ++tx)
+    {
+        mini_hash short_id;
+        const auto id = to_little_endian(siphash(key, tx->hash(witness)));
+        std::copy_n(id.begin(), short_id.size(), short_id.begin());
+        short_ids.push_back(short_id);
+    }
+
+    // The coinbase is prefilled, as a peer cannot have it in its pool.
+    const prefilled_transaction::list prefilled{ { 0, txs.front() } };
+    compact = std::make_shared<compact_block>(header, nonce, short_ids,
+        prefilled);
+    block_cache_.set_compact(hash, version, compact);
+    return compact;
 }
 
 void block_chain::fetch_block_height(const hash_digest& hash,
@@ -1155,15 +2555,15 @@ void block_chain::fetch_block_height(const hash_digest& hash,
         return;
     }
 
-    const auto result = database_.blocks().get(hash);
+    size_t height;
 
-    if (!result)
+    if (!get_height(height, hash))
     {
         handler(error::not_found, 0);
         return;
     }
 
-    handler(error::success, result.height());
+    handler(error::success, height);
 }
 
 void block_chain::fetch_last_height(last_height_fetch_handler handler) const
@@ -1195,155 +2595,478 @@ void block_chain::fetch_transaction(const hash_digest& hash,
         return;
     }
 
-    // Try the cached block first if confirmation is not required.
-    if (!require_confirmed)
+    const auto query = [=]()
+    {
+        // Try the transaction cache first if confirmation is not required.
+        if (!require_confirmed)
+        {
+            size_t position;
+            size_t height;
+            transaction_const_ptr cached;
+
+            if (transaction_cache_.get(cached, position, height, hash))
+            {
+                handler(error::success, cached, position, height);
+                return;
+            }
+        }
+
+        const auto result = database_.transactions().get(hash);
+
+        if (!result || (require_confirmed && result.position() ==
+            transaction_result::unconfirmed))
+        {
+            handler(error::not_found, nullptr, 0, 0);
+            return;
+        }
+
+        // TODO: tx state may not be publishable.
+        const auto tx = std::make_shared<const transaction>(
+            result.transaction(witness));
+        handler(error::success, tx, result.position(), result.height());
+    };
+
+    if (!query_executor_.execute(transaction_query, query))
+        handler(error::oversubscribed, nullptr, 0, 0);
+}
+
+// Links are read in file order, so the batch walks the memory map forward.
+void block_chain::fetch_transactions(const hash_list& hashes,
+    bool require_confirmed, bool witness,
+    transactions_fetch_handler handler) const
+{
+    if (stopped())
+    {
+        handler(error::service_stopped, {});
+        return;
+    }
+
+    const auto query = [=]()
+    {
+        typedef std::pair<file_offset, size_t> link;
+        std::vector<link> links;
+        links.reserve(hashes.size());
+        transaction_const_ptr_list transactions(hashes.size());
+        const auto& tx_store = database_.transactions();
+
+        // Resolve each hash to its link, trying the transaction cache first.
+        for (size_t index = 0; index < hashes.size(); ++index)
+        {
+            const auto& hash = hashes[index];
+
+            if (!require_confirmed)
+            {
+                size_t position;
+                size_t height;
+
+                if (transaction_cache_.get(transactions[index], position,
+                    height, hash))
+                    continue;
+            }
+
+            const auto result = tx_store.get(hash);
+
+            if (!result || (require_confirmed && result.position() ==
+                transaction_result::unconfirmed))
+                continue;
+
+            links.emplace_back(result.link(), index);
+        }
+
+        std::sort(links.begin(), links.end());
+        std::vector<file_offset> offsets;
+        offsets.reserve(links.size());
+
+        for (const auto& entry: links)
+            offsets.push_back(entry.first);
+
+        transaction::list txs;
+
+        // TODO: tx state may not be publishable.
+        if (!get_transactions(txs, std::move(offsets), witness))
+        {
+            handler(error::operation_failed, {});
+            return;
+        }
+
+        // Return the transactions to request order.
+        for (size_t index = 0; index < links.size(); ++index)
+            transactions[links[index].second] =
+                std::make_shared<const transaction>(std::move(txs[index]));
+
+        handler(error::success, std::move(transactions));
+    };
+
+    if (!query_executor_.execute(transaction_query, query))
+        handler(error::oversubscribed, {});
+}
+
+// This is same as fetch_transaction but skips deserializing the tx payload.
+void block_chain::fetch_transaction_position(const hash_digest& hash,
+    bool require_confirmed, transaction_index_fetch_handler handler) const
+{
+    if (stopped())
+    {
+        handler(error::service_stopped, 0, 0);
+        return;
+    }
+
+    const auto query = [=]()
+    {
+        // Try the transaction cache first if confirmation is not required.
+        if (!require_confirmed)
+        {
+            size_t position;
+            size_t height;
+            transaction_const_ptr cached;
+
+            if (transaction_cache_.get(cached, position, height, hash))
+            {
+                handler(error::success, position, height);
+                return;
+            }
+        }
+
+        const auto result = database_.transactions().get(hash);
+
+        if (!result || (require_confirmed && result.position() ==
+            transaction_result::unconfirmed))
+        {
+            handler(error::not_found, 0, 0);
+            return;
+        }
+
+        handler(error::success, result.position(), result.height());
+    };
+
+    if (!query_executor_.execute(transaction_query, query))
+        handler(error::oversubscribed, 0, 0);
+}
+
+// private
+// Wait out any confirmed chain write and return the (even) epoch.
+size_t block_chain::begin_confirmed_read() const
+{
+    auto epoch = confirmed_epoch_.load();
+
+    while ((epoch % 2u) != 0u)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        epoch = confirmed_epoch_.load();
+    }
+
+    return epoch;
+}
+
+// private
+// The read is consistent if no confirmed chain write intervened.
+bool block_chain::end_confirmed_read(size_t epoch) const
+{
+    return confirmed_epoch_.load() == epoch;
+}
+
+// private
+// Confirmed chain writes are serialized by the validation mutex.
+void block_chain::begin_confirmed_write()
+{
+    ++confirmed_epoch_;
+    BITCOIN_ASSERT((confirmed_epoch_.load() % 2u) != 0u);
+}
+
+// private
+void block_chain::end_confirmed_write()
+{
+    ++confirmed_epoch_;
+    BITCOIN_ASSERT((confirmed_epoch_.load() % 2u) == 0u);
+}
+
+// private
+// Read up to limit payment rows, most recent first. The scan ends at the
+// first tx below from_height, which requires the height of each tx, so each is
+// then resolved as read (once, as its rows are adjacent). Otherwise no row is
+// resolved, and the caller resolves all in one batch.
+void block_chain::get_payments(chain::payment_record::list& out_payments,
+    const short_hash& address_hash, size_t limit, size_t from_height) const
+{
+    hash_digest hash;
+    size_t height = 0;
+
+    // Result set is ordered most recent tx first (reverse point order in tx).
+    for (auto payment: database_.addresses().get(address_hash))
     {
-        const auto cached = last_transaction_.load();
+        if (out_payments.size() == limit)
+            return;
 
-        if (cached && cached->metadata.state && cached->hash() == hash)
+        if (from_height != 0)
         {
-            ////LOG_INFO(LOG_BLOCKCHAIN) << "TX CACHE HIT";
-            const auto height = cached->metadata.state->height();
-            handler(error::success, cached, 0, height);
-            return;
+            if (out_payments.empty() ||
+                out_payments.back().link() != payment.link())
+            {
+                const auto tx = database_.transactions().get(payment.link());
+                height = tx.height();
+                hash = tx.hash();
+
+                // Rows are most recent first, so none that follow are.
+                if (height < from_height)
+                    return;
+            }
+
+            payment.set_height(height);
+            payment.set_hash(hash);
         }
+
+        out_payments.push_back(payment);
     }
+}
+
+// private
+// Set the height and hash of each payment, resolving each tx once and in
+// link order (store locality). Payments may be from any number of addresses.
+void block_chain::set_payment_links(payment_pointers& payments) const
+{
+    const auto by_link = [](const chain::payment_record* left,
+        const chain::payment_record* right)
+    {
+        return left->link() < right->link();
+    };
 
-    const auto result = database_.transactions().get(hash);
+    std::sort(payments.begin(), payments.end(), by_link);
+    hash_digest hash;
+    size_t height = 0;
 
-    if (!result || (require_confirmed && result.position() !=
-        transaction_result::unconfirmed))
+    // Rows of the same tx are adjacent in link order, so resolve it once.
+    for (size_t index = 0; index < payments.size(); ++index)
     {
-        handler(error::not_found, nullptr, 0, 0);
-        return;
-    }
+        const auto payment = payments[index];
+
+        if (index == 0 || payments[index - 1u]->link() != payment->link())
+        {
+            const auto tx = database_.transactions().get(payment->link());
+            height = tx.height();
+            hash = tx.hash();
+        }
 
-    // TODO: tx state may not be publishable.
-    const auto tx = std::make_shared<const transaction>(
-        result.transaction(witness));
-    handler(error::success, tx, result.position(), result.height());
+        payment->set_height(height);
+        payment->set_hash(hash);
+    }
 }
 
-// This is same as fetch_transaction but skips deserializing the tx payload.
-void block_chain::fetch_transaction_position(const hash_digest& hash,
-    bool require_confirmed, transaction_index_fetch_handler handler) const
+// private
+// Rows are most recent first, so remove from the first below from_height.
+bool block_chain::trim_payments(chain::payment_record::list& payments,
+    size_t from_height)
 {
-    if (stopped())
+    for (auto it = payments.begin(); it != payments.end(); ++it)
     {
-        handler(error::service_stopped, 0, 0);
-        return;
+        if (it->height() < from_height)
+        {
+            payments.erase(it, payments.end());
+            return true;
+        }
     }
 
-    // Try the cached block first if confirmation is not required.
-    if (!require_confirmed)
+    return false;
+}
+
+// private
+// Read and resolve the payments of up to limit rows that follow the cursor,
+// stopping at the first below from_height. The rows of a tx are adjacent, and
+// a page always ends with all rows of its last tx. Each page is resolved as
+// one batch in link order. The cursor is one past the link of the last tx
+// returned, so it is stable as new rows are prepended. Returns the next
+// cursor, or zero if complete. If resumable the next page is held open.
+size_t block_chain::get_history(chain::payment_record::list& out_payments,
+    const short_hash& address_hash, size_t cursor, size_t limit,
+    size_t from_height, bool resumable) const
+{
+    if (limit == 0)
+        return 0;
+
+    auto history = cursor == 0 ? nullptr : take_cursor(address_hash, cursor);
+
+    if (!history)
     {
-        const auto cached = last_transaction_.load();
+        history = std::make_shared<history_cursor>(
+            database_.addresses().get(address_hash));
 
-        if (cached && cached->metadata.state && cached->hash() == hash)
+        // The cursor has expired, so rows above it are walked (not resolved).
+        if (cursor != 0)
         {
-            ////LOG_INFO(LOG_BLOCKCHAIN) << "TX CACHE HIT";
-            const auto height = cached->metadata.state->height();
-            handler(error::success, 0, height);
-            return;
+            auto& row = history->row;
+            const auto end = history->rows.end();
+
+            while (row != end && (*row).link() + 1u != cursor)
+                ++row;
+
+            while (row != end && (*row).link() + 1u == cursor)
+                ++row;
         }
     }
 
-    const auto result = database_.transactions().get(hash);
+    auto& row = history->row;
+    const auto end = history->rows.end();
 
-    if (!result || (require_confirmed && result.position() !=
-        transaction_result::unconfirmed))
+    // Result set is ordered most recent tx first (reverse point order in tx).
+    for (; row != end; ++row)
     {
-        handler(error::not_found, 0, 0);
-        return;
+        const auto payment = *row;
+
+        // The page is full, end it at this tx boundary.
+        if (out_payments.size() >= limit &&
+            out_payments.back().link() != payment.link())
+            break;
+
+        out_payments.push_back(payment);
     }
 
-    handler(error::success, result.position(), result.height());
+    payment_pointers payments;
+    payments.reserve(out_payments.size());
+
+    for (auto& payment: out_payments)
+        payments.push_back(&payment);
+
+    set_payment_links(payments);
+
+    // Rows are most recent first, so none that follow are in range.
+    if (trim_payments(out_payments, from_height) || row == end)
+        return 0;
+
+    const auto next = static_cast<size_t>(out_payments.back().link() + 1u);
+
+    if (resumable)
+        put_cursor(address_hash, next, history);
+
+    return next;
 }
 
-// This may execute over 500 queries.
-void block_chain::fetch_locator_block_hashes(get_blocks_const_ptr locator,
-    const hash_digest& threshold, size_t limit,
-    inventory_fetch_handler handler) const
+// private
+// The cursor is removed, so that concurrent pages do not share an iterator.
+block_chain::history_cursor_ptr block_chain::take_cursor(
+    const short_hash& address_hash, size_t cursor) const
 {
-    if (stopped())
-    {
-        handler(error::service_stopped, nullptr);
-        return;
-    }
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(history_mutex_);
+    const auto it = history_cursors_.find({ address_hash, cursor });
+
+    if (it == history_cursors_.end())
+        return nullptr;
+
+    const auto history = it->second;
+    history_cursors_.erase(it);
+    return history;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// Cursors are bounded, abandoned pages are not otherwise expired.
+void block_chain::put_cursor(const short_hash& address_hash, size_t cursor,
+    history_cursor_ptr history) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(history_mutex_);
 
-    // BUGBUG: an intervening reorg can produce an invalid chain of hashes.
-    // TODO: instead walk backwards using parent hash lookups.
+    if (history_cursors_.size() >= history_cursor_limit)
+        history_cursors_.erase(history_cursors_.begin());
+
+    history_cursors_[{ address_hash, cursor }] = history;
+    ///////////////////////////////////////////////////////////////////////////
+}
 
+// private
+// Resolve the confirmed height range [begin, end) indicated by a locator.
+void block_chain::get_locator_range(size_t& out_begin, size_t& out_end,
+    const hash_list& start_hashes, const hash_digest& stop_hash,
+    const hash_digest& threshold, size_t limit) const
+{
     // This is based on the idea that looking up by block hash to get heights
     // will be much faster than hashing each retrieved block to test for stop.
 
     // Find the start block height.
     // If no start block is on our chain we start with block 0.
     // TODO: we could return error or empty and drop peer for missing genesis.
+    uint8_t state;
     size_t start = 0;
-    for (const auto& hash: locator->start_hashes())
-    {
-        const auto result = database_.blocks().get(hash);
-        if (result)
-        {
-            start = result.height();
+    for (const auto& hash: start_hashes)
+        if (confirmed_columns_.find(start, state, hash))
             break;
-        }
-    }
 
     // The begin block requested is always one after the start block.
-    auto begin = safe_add(start, size_t(1));
+    out_begin = safe_add(start, size_t(1));
 
-    // The maximum number of headers returned is 500.
-    auto end = safe_add(begin, limit);
+    // The maximum number of headers returned is the limit.
+    out_end = safe_add(out_begin, limit);
 
     // Find the upper threshold block height (peer-specified).
-    if (locator->stop_hash() != null_hash)
+    size_t height;
+    if (stop_hash != null_hash)
     {
         // If the stop block is not confirmed we treat it as a null stop.
-        const auto result = database_.blocks().get(locator->stop_hash());
-
         // Otherwise limit the end height to the stop block height.
         // If end precedes begin floor_subtract will handle below.
-        if (result)
-            end = std::min(result.height(), end);
+        if (confirmed_columns_.find(height, state, stop_hash))
+            out_end = std::min(height, out_end);
     }
 
     // Find the lower threshold block height (self-specified).
     if (threshold != null_hash)
     {
         // If the threshold is not confirmed we ignore it.
-        const auto result = database_.blocks().get(threshold);
-
         // Otherwise limit the begin height to the threshold block height.
         // If begin exceeds end floor_subtract will handle below.
-        if (result)
-            begin = std::max(result.height(), begin);
+        if (confirmed_columns_.find(height, state, threshold))
+            out_begin = std::max(height, out_begin);
     }
+}
 
-    auto hashes = std::make_shared<inventory>();
-    hashes->inventories().reserve(floor_subtract(end, begin));
-
-    // Build the hash list until we hit end or the blockchain top.
-    for (auto height = begin; height < end; ++height)
+// This reads the confirmed columns (no store reads).
+void block_chain::fetch_locator_block_hashes(get_blocks_const_ptr locator,
+    const hash_digest& threshold, size_t limit,
+    inventory_fetch_handler handler) const
+{
+    if (stopped())
     {
-        const auto result = database_.blocks().get(height, false);
+        handler(error::service_stopped, nullptr);
+        return;
+    }
 
-        // If not found then we are at our top.
-        if (!result)
+    const auto query = [=]()
+    {
+        size_t begin;
+        size_t end;
+        size_t epoch;
+        inventory_ptr hashes;
+
+        // Retry if the confirmed chain changes, as the range and hashes must be
+        // read from the same chain. This reads only the confirmed columns.
+        do
         {
-            hashes->inventories().shrink_to_fit();
-            break;
-        }
+            epoch = begin_confirmed_read();
+            get_locator_range(begin, end, locator->start_hashes(),
+                locator->stop_hash(), threshold, limit);
 
-        static const auto id = inventory::type_id::block;
-        hashes->inventories().emplace_back(id, result.hash());
-    }
+            hash_digest hash;
+            hashes = std::make_shared<inventory>();
+            hashes->inventories().reserve(floor_subtract(end, begin));
+
+            // Build the hash list until we hit end or the blockchain top.
+            for (auto height = begin; height < end &&
+                confirmed_columns_.get_block_hash(hash, height); ++height)
+            {
+                static const auto id = inventory::type_id::block;
+                hashes->inventories().emplace_back(id, hash);
+            }
+        } while (!end_confirmed_read(epoch));
+
+        handler(error::success, std::move(hashes));
+    };
 
-    handler(error::success, std::move(hashes));
+    if (!query_executor_.execute(locator_query, query))
+        handler(error::oversubscribed, nullptr);
 }
 
-// This may execute over 2000 queries.
+// This reads a slice of the confirmed headers buffer (no store reads).
 void block_chain::fetch_locator_block_headers(get_headers_const_ptr locator,
     const hash_digest& threshold, size_t limit,
     locator_block_headers_fetch_handler handler) const
@@ -1354,75 +3077,68 @@ void block_chain::fetch_locator_block_headers(get_headers_const_ptr locator,
         return;
     }
 
-    // BUGBUG: an intervening reorg can produce an invalid chain of headers.
-    // TODO: instead walk backwards using parent hash lookups.
-
-    // This is based on the idea that looking up by block hash to get heights
-    // will be much faster than hashing each retrieved block to test for stop.
-
-    // Find the start block height.
-    // If no start block is on our chain we start with block 0.
-    // TODO: we could return error or empty and drop peer for missing genesis.
-    size_t start = 0;
-    for (const auto& hash: locator->start_hashes())
+    const auto query = [=]()
     {
-        const auto result = database_.blocks().get(hash);
-        if (result)
+        size_t begin;
+        size_t end;
+        size_t epoch;
+        data_chunk data;
+
+        // Retry if the confirmed chain changes, as the range and headers must
+        // be read from the same chain. The buffer ends at our top.
+        do
         {
-            start = result.height();
-            break;
-        }
-    }
-
-    // The begin block requested is always one after the start block.
-    auto begin = safe_add(start, size_t(1));
+            data.clear();
+            epoch = begin_confirmed_read();
+            get_locator_range(begin, end, locator->start_hashes(),
+                locator->stop_hash(), threshold, limit);
+            confirmed_headers_.to_data(data, begin, end);
+        } while (!end_confirmed_read(epoch));
 
-    // The maximum number of headers returned is 2000.
-    auto end = safe_add(begin, limit);
+        const auto message = std::make_shared<headers>(
+            headers::factory(version::level::maximum, data));
 
-    // Find the upper threshold block height (peer-specified).
-    if (locator->stop_hash() != null_hash)
-    {
-        // If the stop block is not confirmed we treat it as a null stop.
-        const auto result = database_.blocks().get(locator->stop_hash());
+        handler(error::success, message);
+    };
 
-        // Otherwise limit the end height to the stop block height.
-        // If end precedes begin floor_subtract will handle below.
-        if (result)
-            end = std::min(result.height(), end);
-    }
+    if (!query_executor_.execute(locator_query, query))
+        handler(error::oversubscribed, nullptr);
+}
 
-    // Find the lower threshold block height (self-specified).
-    if (threshold != null_hash)
+// This copies a slice of the confirmed headers buffer (no store reads).
+void block_chain::fetch_locator_block_headers_data(
+    get_headers_const_ptr locator, const hash_digest& threshold,
+    size_t limit, locator_block_headers_data_fetch_handler handler) const
+{
+    if (stopped())
     {
-        // If the threshold is not confirmed we ignore it.
-        const auto result = database_.blocks().get(threshold);
-
-        // Otherwise limit the begin height to the threshold block height.
-        // If begin exceeds end floor_subtract will handle below.
-        if (result)
-            begin = std::max(result.height(), begin);
+        handler(error::service_stopped, nullptr);
+        return;
     }
 
-    auto message = std::make_shared<headers>();
-    message->elements().reserve(floor_subtract(end, begin));
-
-    // Build the hash list until we hit end or the blockchain top.
-    for (auto height = begin; height < end; ++height)
+    const auto query = [=]()
     {
-        const auto result = database_.blocks().get(height, false);
-
-        // If not found then we are at our top.
-        if (!result)
+        size_t begin;
+        size_t end;
+        size_t epoch;
+        const auto data = std::make_shared<data_chunk>();
+
+        // Retry if the confirmed chain changes, as the range and headers must
+        // be read from the same chain. The buffer ends at our top.
+        do
         {
-            message->elements().shrink_to_fit();
-            break;
-        }
+            data->clear();
+            epoch = begin_confirmed_read();
+            get_locator_range(begin, end, locator->start_hashes(),
+                locator->stop_hash(), threshold, limit);
+            confirmed_headers_.to_data(*data, begin, end);
+        } while (!end_confirmed_read(epoch));
 
-        message->elements().push_back(result.header());
-    }
+        handler(error::success, data);
+    };
 
-    handler(error::success, std::move(message));
+    if (!query_executor_.execute(locator_query, query))
+        handler(error::oversubscribed, nullptr);
 }
 
 ////// This may generally execute 29+ queries.
@@ -1496,7 +3212,7 @@ void block_chain::fetch_header_locator(const block::indexes& heights,
 // Confirmed heights only.
 
 // TODO: reimplement in store.
-void block_chain::fetch_spend(const chain::output_point& ,
+void block_chain::fetch_spend(const chain::output_point& outpoint,
     spend_fetch_handler handler) const
 {
     if (stopped())
@@ -1505,17 +3221,82 @@ void block_chain::fetch_spend(const chain::output_point& ,
         return;
     }
 
-    ////auto point = database_.spends().get(outpoint);
+    const auto query = [=]()
+    {
+        if (!settings_.index_spends)
+        {
+            handler(error::not_implemented, {});
+            return;
+        }
+
+        size_t top;
+
+        // A partial index would report spent outputs as unspent, so fail
+        // until it is complete (it is populated in the background).
+        if (!confirmed_columns_.top(top) || spend_index_.height() != top)
+        {
+            handler(error::operation_failed, {});
+            return;
+        }
+
+        chain::input_point spender;
+
+        if (!get_spender(spender, outpoint))
+        {
+            handler(error::not_found, {});
+            return;
+        }
+
+        handler(error::success, std::move(spender));
+    };
+
+    if (!query_executor_.execute(transaction_query, query))
+        handler(error::oversubscribed, {});
+}
+
+void block_chain::fetch_spends(const chain::output_point::list& outpoints,
+    spends_fetch_handler handler) const
+{
+    if (stopped())
+    {
+        handler(error::service_stopped, {});
+        return;
+    }
+
+    const auto query = [=]()
+    {
+        if (!settings_.index_spends)
+        {
+            handler(error::not_implemented, {});
+            return;
+        }
+
+        size_t top;
+
+        // A partial index would report spent outputs as unspent, so fail
+        // until it is complete (it is populated in the background).
+        if (!confirmed_columns_.top(top) || spend_index_.height() != top)
+        {
+            handler(error::operation_failed, {});
+            return;
+        }
+
+        chain::input_point::list spenders;
+        spenders.reserve(outpoints.size());
 
-    ////if (point.hash() == null_hash)
-    ////{
-    ////    handler(error::not_found, {});
-    ////    return;
-    ////}
+        // Unspent outpoints are returned as null points.
+        for (const auto& outpoint: outpoints)
+        {
+            chain::input_point spender{ null_hash, chain::point::null_index };
+            get_spender(spender, outpoint);
+            spenders.push_back(std::move(spender));
+        }
 
-    ////handler(error::success, std::move(point));
+        handler(error::success, std::move(spenders));
+    };
 
-    handler(error::not_implemented, {});
+    if (!query_executor_.execute(transaction_query, query))
+        handler(error::oversubscribed, {});
 }
 
 // TODO: could return an iterator with an internal tx store reference, which
@@ -1530,33 +3311,133 @@ void block_chain::fetch_history(const short_hash& address_hash, size_t limit,
         return;
     }
 
-    // Cannot know size without reading all, so dynamically allocate.
-    chain::payment_record::list payments;
-    size_t count = 0;
+    const auto query = [=]()
+    {
+        chain::payment_record::list payments;
+        get_history(payments, address_hash, 0, limit, from_height, false);
 
-    // Result set is ordered most recent tx first (reverse point order in tx).
-    for (auto payment: database_.addresses().get(address_hash))
+        // The history ends with all rows of a tx, but the limit is of rows.
+        if (payments.size() > limit)
+            payments.resize(limit);
+
+        handler(error::success, std::move(payments));
+    };
+
+    if (!query_executor_.execute(server_query, query))
+        handler(error::oversubscribed, {});
+}
+
+void block_chain::fetch_history_page(const short_hash& address_hash,
+    size_t cursor, size_t page_size, size_t from_height,
+    history_page_fetch_handler handler) const
+{
+    if (stopped())
     {
-        if (count++ == limit)
-            break;
+        handler(error::service_stopped, {}, 0);
+        return;
+    }
 
-        const auto tx = database_.transactions().get(payment.link());
-        const auto height = tx.height();
+    const auto query = [=]()
+    {
+        chain::payment_record::list payments;
+        payments.reserve(page_size);
 
-        if (height < from_height)
-            break;
+        const auto next = get_history(payments, address_hash, cursor,
+            page_size, from_height, true);
+
+        handler(error::success, std::move(payments), next);
+    };
+
+    if (!query_executor_.execute(server_query, query))
+        handler(error::oversubscribed, {}, 0);
+}
+
+// Address scans are distributed as server queries (so within the class
+// limits). Unless scanned to a height, transactions common to multiple
+// addresses are resolved once.
+void block_chain::fetch_history(const short_hash_list& address_hashes,
+    size_t limit, size_t from_height,
+    history_list_fetch_handler handler) const
+{
+    if (stopped())
+    {
+        handler(error::service_stopped, {});
+        return;
+    }
+
+    if (address_hashes.empty())
+    {
+        handler(error::success, {});
+        return;
+    }
+
+    // There is at least one scan, even if queries execute on the caller.
+    const auto buckets = std::max(size_t(1), std::min(query_pool_.size(),
+        address_hashes.size()));
+    const auto hashes = std::make_shared<const short_hash_list>(
+        address_hashes);
+    const auto histories = std::make_shared<payment_lists>(
+        address_hashes.size());
+    const auto complete_handler = std::bind(&block_chain::handle_histories,
+        this, _1, histories, from_height, handler);
+    const auto join_handler = synchronize(std::move(complete_handler),
+        buckets, NAME "_history");
+
+    for (size_t bucket = 0; bucket < buckets; ++bucket)
+    {
+        const auto scan = std::bind(&block_chain::scan_histories, this,
+            hashes, limit, from_height, bucket, buckets, histories,
+            join_handler);
+
+        // The first failure completes the join, subsequent are ignored.
+        if (!query_executor_.execute(server_query, scan))
+            join_handler(error::oversubscribed);
+    }
+}
+
+// private
+void block_chain::scan_histories(short_hash_list_ptr address_hashes,
+    size_t limit, size_t from_height, size_t bucket, size_t buckets,
+    payment_lists_ptr histories, result_handler handler) const
+{
+    BITCOIN_ASSERT(bucket < buckets);
+    const auto& hashes = *address_hashes;
+
+    for (auto index = bucket; index < hashes.size() && !stopped();
+        index = ceiling_add(index, buckets))
+        get_payments((*histories)[index], hashes[index], limit, from_height);
+
+    handler(stopped() ? error::service_stopped : error::success);
+}
+
+// private
+// Rows scanned to a from_height are resolved by the scan.
+void block_chain::handle_histories(const code& ec,
+    payment_lists_ptr histories, size_t from_height,
+    history_list_fetch_handler handler) const
+{
+    if (ec)
+    {
+        handler(ec, {});
+        return;
+    }
+
+    if (from_height == 0)
+    {
+        payment_pointers payments;
+
+        for (auto& history: *histories)
+            for (auto& payment: history)
+                payments.push_back(&payment);
 
-        // Copy of each payment record above so can be modified here.
-        payment.set_height(height);
-        payment.set_hash(tx.hash());
-        payments.push_back(payment);
+        set_payment_links(payments);
     }
 
-    handler(error::success, std::move(payments));
+    handler(error::success, std::move(*histories));
 }
 
-// TODO: eliminate.
-void block_chain::fetch_stealth(const binary&, size_t,
+// Stealth rows are indexed from confirmed blocks, populated after start.
+void block_chain::fetch_stealth(const binary& filter, size_t from_height,
     stealth_fetch_handler handler) const
 {
     if (stopped())
@@ -1565,7 +3446,40 @@ void block_chain::fetch_stealth(const binary&, size_t,
         return;
     }
 
-    handler(error::not_implemented, {});
+    const auto query = [=]()
+    {
+        if (!index_addresses_)
+        {
+            handler(error::not_implemented, {});
+            return;
+        }
+
+        size_t top;
+
+        // A partial index would silently omit payments, so fail until it is
+        // complete (this also fails while a reorganization is being indexed).
+        if (!confirmed_columns_.top(top) || stealth_index_.top() != top)
+        {
+            handler(error::operation_failed, {});
+            return;
+        }
+
+        stealth_index::record::list records;
+        stealth_index_.scan(records, filter, from_height);
+
+        chain::stealth_record::list stealth;
+        stealth.reserve(records.size());
+
+        for (const auto& record: records)
+            stealth.emplace_back(record.height, record.prefix,
+                record.ephemeral_key, record.public_key_hash,
+                record.transaction_hash);
+
+        handler(error::success, std::move(stealth));
+    };
+
+    if (!query_executor_.execute(server_query, query))
+        handler(error::oversubscribed, {});
 }
 
 // Transaction Pool.
@@ -1606,18 +3520,20 @@ void block_chain::filter_blocks(get_data_ptr message,
     // Excludes blocks that are known to block memory pool (not block pool).
     header_pool_.filter(message);
 
-    auto& inventories = message->inventories();
-    for (auto it = inventories.begin(); it != inventories.end();)
+    // Indexed blocks are excluded without a store query.
+    const auto stored = [&](const inventory_vector& inventory)
     {
-        if (it->is_block_type() && !database_.blocks().get(it->hash()))
-        {
-            ++it;
-        }
-        else
-        {
-            it = inventories.erase(it);
-        }
-    }
+        const auto& hash = inventory.hash();
+        return !inventory.is_block_type() ||
+            confirmed_columns_.exists(hash) ||
+            candidate_columns_.exists(hash) ||
+            database_.blocks().get(hash);
+    };
+
+    // Remove stored blocks in a single pass, preserving inventory order.
+    auto& inventories = message->inventories();
+    inventories.erase(std::remove_if(inventories.begin(), inventories.end(),
+        stored), inventories.end());
 
     handler(error::success);
 }
@@ -1637,19 +3553,23 @@ void block_chain::filter_transactions(get_data_ptr message,
     // Excludes tx that are known to the tx memory pool (not tx pool).
     transaction_pool_.filter(message);
 
-    auto& inventories = message->inventories();
-    for (auto it = inventories.begin(); it != inventories.end();)
+    // Recently stored transactions are excluded without a store query. Once
+    // the filter is primed a miss means the transaction is not stored, so new
+    // transactions rarely query the store.
+    const auto primed = transaction_filter_primed_.load();
+    const auto stored = [&](const inventory_vector& inventory)
     {
-        if (it->is_transaction_type() &&
-            !database_.transactions().get(it->hash()))
-        {
-            ++it;
-        }
-        else
-        {
-            it = inventories.erase(it);
-        }
-    }
+        const auto& hash = inventory.hash();
+        return !inventory.is_transaction_type() ||
+            transaction_cache_.exists(hash) ||
+            ((!primed || transaction_filter_.contains(hash)) &&
+                database_.transactions().get(hash));
+    };
+
+    // Remove stored transactions in a single pass, preserving inventory order.
+    auto& inventories = message->inventories();
+    inventories.erase(std::remove_if(inventories.begin(), inventories.end(),
+        stored), inventories.end());
 
     handler(error::success);
 }
@@ -1720,6 +3640,12 @@ void block_chain::organize(header_const_ptr header, result_handler handler)
     header_organizer_.organize(header, handler);
 }
 
+void block_chain::organize(headers_const_ptr headers, result_handler handler)
+{
+    // The handler must not call organize (lock safety).
+    header_organizer_.organize(headers, handler);
+}
+
 void block_chain::organize(transaction_const_ptr tx, result_handler handler)
 {
     // The handler must not call organize (lock safety).
@@ -18,9 +18,11 @@
  */
 #include <bitcoin/blockchain/organizers/block_organizer.hpp>
 
+#include <atomic>
 #include <cstddef>
 #include <functional>
 #include <future>
+#include <map>
 #include <memory>
 #include <utility>
 #include <bitcoin/bitcoin.hpp>
@@ -36,12 +38,25 @@ using namespace std::placeholders;
 
 #define NAME "block_organizer"
 
+// The block read ahead is claimed by either its dispatch or its consumer, so
+// the consumer never waits on a read that has not started.
+struct block_organizer::block_reader
+{
+    size_t height;
+    std::atomic<bool> claimed;
+    std::promise<block_const_ptr> promise;
+    std::future<block_const_ptr> block;
+};
+
 block_organizer::block_organizer(prioritized_mutex& mutex,
     dispatcher& priority_dispatch, threadpool& threads, fast_chain& chain,
     const settings& settings, const bc::settings& bitcoin_settings)
   : fast_chain_(chain),
     mutex_(mutex),
     stopped_(true),
+    dispatch_(threads, NAME "_dispatch"),
+    held_limit_(settings.block_cache_capacity),
+    held_(0),
     validator_(priority_dispatch, chain, settings, bitcoin_settings),
     downloader_subscriber_(std::make_shared<download_subscriber>(threads, NAME))
 {
@@ -95,7 +110,11 @@ code block_organizer::organize(block_const_ptr block, size_t height)
     const auto error_code = fast_chain_.update(block, height);
     //#########################################################################
 
-    // TODO: cache block as last downloaded (for fast top validation).
+    // The block waits in the ready set until all blocks below it are valid.
+    // It is held there for validation, so that it is not read from the store.
+    if (!error_code)
+        set_ready(height, block->header().metadata.error ? nullptr : block);
+
     // Queue download notification to invoke validation on downloader thread.
     downloader_subscriber_->relay(error_code, block->hash(), height);
 
@@ -104,13 +123,51 @@ code block_organizer::organize(block_const_ptr block, size_t height)
     return error_code;
 }
 
+// Candidates popped by a header reorganization are no longer ready.
+bool block_organizer::handle_reorganized(code ec, size_t fork_height,
+    header_const_ptr_list_const_ptr,
+    header_const_ptr_list_const_ptr outgoing)
+{
+    if (ec)
+        return false;
+
+    if (outgoing && !outgoing->empty())
+        clear_ready(fork_height + 1u, true);
+
+    return true;
+}
+
 // TODO: refactor to eliminate this abstraction leak.
 void block_organizer::prime_validation(const hash_digest& hash,
     size_t height) const
 {
+    set_ready(height);
     downloader_subscriber_->relay(error::success, hash, height);
 }
 
+// The downloader should prioritize these, as validation waits on the first.
+void block_organizer::get_gaps(block::indexes& out_heights,
+    size_t limit) const
+{
+    auto height = fast_chain_.top_valid_candidate_state()->height() + 1u;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    ready_mutex_.lock_shared();
+
+    for (auto it = ready_.lower_bound(height);
+        it != ready_.end() && out_heights.size() < limit; ++it)
+    {
+        for (; height < it->first && out_heights.size() < limit; ++height)
+            out_heights.push_back(height);
+
+        height = it->first + 1u;
+    }
+
+    ready_mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
 // Validate sequence.
 //-----------------------------------------------------------------------------
 // This runs in single thread normal priority except validation fan-outs.
@@ -126,9 +183,15 @@ bool block_organizer::handle_check(const code& ec, const hash_digest& hash,
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
     mutex_.lock_high_priority();
+    const auto top_valid = fast_chain_.top_valid_candidate_state()->height();
+
+    // Entries at or below the top valid candidate can no longer be validated
+    // (e.g. a late duplicate download), so release them on each pass.
+    prune_ready(top_valid);
 
-    // If initial height is misaligned try again on next download.
-    if (fast_chain_.top_valid_candidate_state()->height() != height - 1u)
+    // If initial height is misaligned the block waits in the ready set, and is
+    // validated in sequence once the download that closes the gap arrives.
+    if (top_valid != height - 1u)
     {
         //---------------------------------------------------------------------
         mutex_.unlock_high_priority();
@@ -137,16 +200,24 @@ bool block_organizer::handle_check(const code& ec, const hash_digest& hash,
 
     // Stack up the validated blocks for possible reorganization.
     auto branch_cache = std::make_shared<block_const_ptr_list>();
+    auto reader = start_read(height);
     code error_code;
 
-    for (auto current_height = height; !stopped() && current_height != 0;
+    // Validation continues through the ready set until the first gap.
+    for (auto current_height = height; !stopped() && reader;
         ++current_height)
     {
-        // TODO: check last downloaded cache first (for fast top validation).
-        // TODO: create parallel block reader (this is expensive and serial).
-        // TODO: this can run in the block populator using priority dispatch.
+        // The downloaded block is normally held in the ready set. Otherwise
+        // this reads the store, and large blocks are deserialized across the
+        // priority pool. Blocks are shared with queries only once valid.
         // TODO: consider metadata population in line with block read.
-        auto block = fast_chain_.get_block(current_height, true, true);
+        auto block = finish_read(reader);
+
+        // Read the next block while this block is validated and committed.
+        // A read ahead of a block that fails (or of a stale candidate) is
+        // discarded, as the next block must follow the top valid candidate.
+        reader = is_ready(current_height + 1u) ?
+            start_read(current_height + 1u) : nullptr;
 
         // If hash is misaligned we must be looking at an expired notification.
         if (!block || fast_chain_.top_valid_candidate_state()->hash() !=
@@ -165,6 +236,9 @@ bool block_organizer::handle_check(const code& ec, const hash_digest& hash,
             error_code = fast_chain_.invalidate(block, current_height);
             //#################################################################
 
+            // Candidates at and above the block have been popped.
+            clear_ready(current_height, true);
+
             // Candidate chain is invalid at this point so break here.
             break;
         }
@@ -175,6 +249,7 @@ bool block_organizer::handle_check(const code& ec, const hash_digest& hash,
             error_code = fast_chain_.candidate(block);
             //#################################################################
             branch_cache->push_back(block);
+            clear_ready(current_height, false);
 
             if (error_code)
                 break;
@@ -213,6 +288,129 @@ bool block_organizer::handle_check(const code& ec, const hash_digest& hash,
     return !error_code;
 }
 
+// Ready set.
+//-----------------------------------------------------------------------------
+
+// private
+// Downloaded blocks are held up to the limit, beyond which they are read.
+void block_organizer::set_ready(size_t height, block_const_ptr block) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(ready_mutex_);
+    auto& slot = ready_[height];
+
+    if (slot)
+        --held_;
+
+    slot = held_ < held_limit_ ? block : nullptr;
+
+    if (slot)
+        ++held_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// A populated candidate may not be in the ready set (e.g. populated before
+// start and not yet primed), so the candidate index is then consulted.
+bool block_organizer::is_ready(size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    ready_mutex_.lock_shared();
+    const auto ready = ready_.find(height) != ready_.end();
+    ready_mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    hash_digest hash;
+    return ready || fast_chain_.get_validatable(hash, height);
+}
+
+// private
+// The held block at the height, or nullptr if not held. A download may race a
+// header reorganization, so the block must be the candidate at the height.
+block_const_ptr block_organizer::get_ready(size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    ready_mutex_.lock_shared();
+    const auto it = ready_.find(height);
+    const auto block = it == ready_.end() ? nullptr : it->second;
+    ready_mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    hash_digest hash;
+    return block && fast_chain_.get_block_hash(hash, height, true) &&
+        hash == block->hash() ? block : nullptr;
+}
+
+// private
+void block_organizer::clear_ready(size_t height, bool above) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(ready_mutex_);
+    const auto first = ready_.lower_bound(height);
+    const auto last = above ? ready_.end() : ready_.upper_bound(height);
+    release(first, last);
+    ready_.erase(first, last);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+void block_organizer::prune_ready(size_t top_height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(ready_mutex_);
+    const auto last = ready_.upper_bound(top_height);
+    release(ready_.begin(), last);
+    ready_.erase(ready_.begin(), last);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// Guarded by the caller.
+void block_organizer::release(ready_blocks::const_iterator first,
+    ready_blocks::const_iterator last) const
+{
+    for (auto it = first; it != last; ++it)
+        if (it->second)
+            --held_;
+}
+
+// Read sub-sequence.
+//-----------------------------------------------------------------------------
+
+// private
+block_organizer::block_reader_ptr block_organizer::start_read(size_t height)
+{
+    const auto reader = std::make_shared<block_reader>();
+    reader->height = height;
+    reader->claimed = false;
+    reader->block = reader->promise.get_future();
+    dispatch_.concurrent(&block_organizer::read_block, this, reader);
+    return reader;
+}
+
+// private
+block_const_ptr block_organizer::finish_read(block_reader_ptr reader)
+{
+    read_block(reader);
+    return reader->block.get();
+}
+
+// private
+void block_organizer::read_block(block_reader_ptr reader)
+{
+    if (reader->claimed.exchange(true))
+        return;
+
+    const auto block = get_ready(reader->height);
+    reader->promise.set_value(block ? block :
+        fast_chain_.get_block(reader->height, true, true));
+}
+
 // private
 // Convert validate.accept/connect to a sequential call.
 code block_organizer::validate(block_const_ptr block)
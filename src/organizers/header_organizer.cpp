@@ -21,6 +21,7 @@
 #include <cstddef>
 #include <functional>
 #include <future>
+#include <iterator>
 #include <memory>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/blockchain/interface/fast_chain.hpp>
@@ -117,6 +118,85 @@ void header_organizer::organize(header_const_ptr header,
     validator_.accept(branch, accept_handler);
 }
 
+// This is called from block_chain::organize.
+// The linked run is accepted and written as one branch in one critical section.
+void header_organizer::organize(headers_const_ptr headers,
+    result_handler handler)
+{
+    code error_code;
+    const auto& elements = headers->elements();
+
+    if (elements.empty())
+    {
+        handler(error::success);
+        return;
+    }
+
+    // Each header must link to its predecessor in the message.
+    if (!headers->is_sequential())
+    {
+        handler(error::orphan_block);
+        return;
+    }
+
+    header_const_ptr_list run;
+    run.reserve(elements.size());
+
+    // Checks that are independent of chain state.
+    for (const auto& element: elements)
+    {
+        const auto header = std::make_shared<const message::header>(element);
+
+        if ((error_code = validator_.check(header)))
+        {
+            handler(error_code);
+            return;
+        }
+
+        run.push_back(header);
+    }
+
+    const result_handler complete =
+        std::bind(&header_organizer::handle_complete,
+            this, _1, handler);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_high_priority();
+
+    const auto known = [&](const header_const_ptr& header)
+    {
+        return pool_.exists(header) ||
+            is_candidate(fast_chain_.get_block_state(header->hash()));
+    };
+
+    // Skip the leading headers of an overlapping run (pooled or candidate).
+    auto first = run.begin();
+    while (first != run.end() && known(*first))
+        ++first;
+
+    // The pool is safe for filtering only, so protect by critical section.
+    // This sets height and presumes the fork point is an indexed header.
+    const auto branch = first == run.end() ? std::make_shared<header_branch>() :
+        pool_.get_branch(*first);
+
+    if (branch->empty())
+    {
+        complete(error::duplicate_block);
+        return;
+    }
+
+    const auto rest = std::make_shared<const header_const_ptr_list>(
+        std::next(first), run.end());
+
+    const auto accept_handler =
+        std::bind(&header_organizer::handle_accept_run,
+            this, _1, branch, rest, complete);
+
+    // Ground the branch and accept the first new header of the run.
+    validator_.accept(branch, accept_handler);
+}
+
 // private
 void header_organizer::handle_complete(const code& ec, result_handler handler)
 {
@@ -149,24 +229,83 @@ void header_organizer::handle_accept(const code& ec, header_branch::ptr branch,
         return;
     }
 
-    // The top block is valid even if the branch has insufficient work.
-    const auto top = branch->top();
-    const auto work = branch->work();
-    uint256_t required_work;
+    // The top header is valid even if the branch has insufficient work.
+    handler(connect(branch, 1));
+}
 
-    // This stops before the height or at the work level, which ever is first.
-    if (!fast_chain_.get_work(required_work, work, branch->height(), true))
+// private
+void header_organizer::handle_accept_run(const code& ec,
+    header_branch::ptr branch, header_const_ptr_list_const_ptr run,
+    result_handler handler)
+{
+    if (stopped())
+    {
+        handler(error::service_stopped);
+        return;
+    }
+
+    if (ec)
     {
-        handler(error::operation_failed);
+        handler(ec);
         return;
     }
 
+    code error_code;
+    size_t accepted = 1;
+
+    // Promote state from each accepted header to its successor and accept it
+    // (each acceptance reads the store to populate the header's own state).
+    for (const auto& header: *run)
+    {
+        if ((error_code = accept(branch, header)))
+            break;
+
+        ++accepted;
+    }
+
+    // The valid prefix of the run is connected even if a header fails.
+    const auto connect_code = connect(branch, accepted);
+    handler(connect_code ? connect_code : error_code);
+}
+
+// private
+// Accept the header on the state of the branch top and append it on success.
+code header_organizer::accept(header_branch::ptr branch,
+    header_const_ptr header) const
+{
+    const auto& parent = *branch->top();
+    header->metadata.state = fast_chain_.promote_state(*header,
+        parent.metadata.state);
+
+    code error_code;
+    if ((error_code = validator_.accept(*header)))
+        return error_code;
+
+    return branch->append(header) ? error::success : error::orphan_block;
+}
+
+// private
+// Compare branch work once and write the branch or pool its top headers.
+code header_organizer::connect(header_branch::ptr branch, size_t count)
+{
+    BITCOIN_ASSERT(count <= branch->size());
+    const auto work = branch->work();
+    uint256_t required_work;
+
+    // This is the candidate work above the branch point (no store reads).
+    if (!fast_chain_.get_work(required_work, work, branch->height(), true))
+        return error::operation_failed;
+
     // Consensus.
     if (work <= required_work)
     {
-        pool_.add(top, branch->top_height());
-        handler(error::insufficient_work);
-        return;
+        const auto headers = branch->headers();
+        const auto first = headers->end() - count;
+        const auto pooled = std::make_shared<const header_const_ptr_list>(
+            first, headers->end());
+
+        pool_.add(pooled, branch->top_height() - count + 1);
+        return error::insufficient_work;
     }
 
     //#########################################################################
@@ -179,12 +318,9 @@ void header_organizer::handle_accept(const code& ec, header_branch::ptr branch,
         LOG_FATAL(LOG_BLOCKCHAIN)
             << "Failure writing header to store, is now corrupted: "
             << error_code.message();
-
-        handler(error_code);
-        return;
     }
 
-    handler(error_code);
+    return error_code;
 }
 
 } // namespace blockchain
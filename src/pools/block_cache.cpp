@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/pools/block_cache.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+block_cache::block_cache(size_t capacity)
+  : capacity_(capacity)
+{
+    map_.reserve(capacity_);
+}
+
+size_t block_cache::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto count = queue_.size();
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return count;
+}
+
+void block_cache::add(block_const_ptr block)
+{
+    if (capacity_ == 0)
+        return;
+
+    const auto hash = block->hash();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    const auto it = map_.find(hash);
+
+    // Replace an existing block, as the new instance may carry metadata.
+    if (it != map_.end())
+    {
+        it->second->block = block;
+        queue_.splice(queue_.begin(), queue_, it->second);
+        return;
+    }
+
+    if (queue_.size() == capacity_)
+    {
+        map_.erase(queue_.back().block->hash());
+        queue_.pop_back();
+    }
+
+    queue_.push_front({ block, nullptr });
+    map_.emplace(hash, queue_.begin());
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+block_const_ptr block_cache::get(const hash_digest& hash) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    const auto it = map_.find(hash);
+
+    if (it == map_.end())
+        return {};
+
+    queue_.splice(queue_.begin(), queue_, it->second);
+    return it->second->block;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Compact blocks are held by BIP152 version, short ids differ by version.
+void block_cache::set_compact(const hash_digest& hash, uint64_t version,
+    compact_block_ptr compact)
+{
+    if (version != 1 && version != 2)
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    const auto it = map_.find(hash);
+
+    if (it != map_.end())
+        it->second->compacts[version - 1u] = compact;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+compact_block_ptr block_cache::get_compact(const hash_digest& hash,
+    uint64_t version) const
+{
+    if (version != 1 && version != 2)
+        return {};
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    const auto it = map_.find(hash);
+
+    if (it == map_.end())
+        return {};
+
+    queue_.splice(queue_.begin(), queue_, it->second);
+    return it->second->compacts[version - 1u];
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void block_cache::remove(const hash_digest& hash)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    const auto it = map_.find(hash);
+
+    if (it == map_.end())
+        return;
+
+    queue_.erase(it->second);
+    map_.erase(it);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void block_cache::clear()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    queue_.clear();
+    map_.clear();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
@@ -60,6 +60,23 @@ bool header_branch::push(header_const_ptr header)
     return false;
 }
 
+// The back is the top of the branch, the header must be its successor.
+bool header_branch::append(header_const_ptr header)
+{
+    const auto linked = [this](header_const_ptr header)
+    {
+        return header->previous_block_hash() == headers_->back()->hash();
+    };
+
+    if (empty() || linked(header))
+    {
+        headers_->push_back(header);
+        return true;
+    }
+
+    return false;
+}
+
 header_const_ptr header_branch::top_parent() const
 {
     const auto count = size();
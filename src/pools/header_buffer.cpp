@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/pools/header_buffer.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+using namespace bc::message;
+
+size_t header_buffer::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto count = buffer_.size() / record_size;
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return count;
+}
+
+size_t header_buffer::to_data(data_chunk& out_data, size_t begin,
+    size_t end) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    end = std::min(end, buffer_.size() / record_size);
+    const auto count = floor_subtract(end, begin);
+    const auto size = count * record_size;
+
+    out_data.reserve(out_data.size() + variable_uint_size(count) + size);
+    data_sink ostream(out_data);
+    ostream_writer sink(ostream);
+    sink.write_size_little_endian(count);
+
+    if (count != 0)
+        sink.write_bytes(&buffer_[begin * record_size], size);
+
+    ostream.flush();
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return count;
+}
+
+void header_buffer::push(const chain::header& header)
+{
+    const auto data = header.to_data(true);
+    BITCOIN_ASSERT(data.size() + 1u == record_size);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    buffer_.insert(buffer_.end(), data.begin(), data.end());
+    buffer_.push_back(0x00);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void header_buffer::truncate(size_t height)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (height < buffer_.size() / record_size)
+        buffer_.resize(height * record_size);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void header_buffer::clear()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    buffer_.clear();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
@@ -0,0 +1,198 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/pools/transaction_cache.hpp>
+
+#include <cstddef>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+transaction_cache::transaction_cache(size_t capacity)
+  : capacity_(capacity == 0 ? 0 : (capacity + shard_count - 1) / shard_count),
+    hits_(0),
+    misses_(0)
+{
+    for (auto& shard: shards_)
+        shard.lookup.reserve(capacity_);
+}
+
+size_t transaction_cache::size() const
+{
+    size_t count = 0;
+
+    for (const auto& shard: shards_)
+    {
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        shard.mutex.lock_shared();
+        count += shard.entries.size();
+        shard.mutex.unlock_shared();
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    return count;
+}
+
+size_t transaction_cache::hits() const
+{
+    return hits_.load();
+}
+
+size_t transaction_cache::misses() const
+{
+    return misses_.load();
+}
+
+void transaction_cache::add(transaction_const_ptr tx, size_t position,
+    size_t height)
+{
+    if (capacity_ == 0)
+        return;
+
+    const auto hash = tx->hash();
+    auto& shard = get_shard(hash);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(shard.mutex);
+    const auto it = shard.lookup.find(hash);
+
+    // Replace an existing entry, as the new instance may carry metadata.
+    if (it != shard.lookup.end())
+    {
+        *it->second = { tx, position, height };
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+
+    if (shard.entries.size() == capacity_)
+    {
+        shard.lookup.erase(shard.entries.back().tx->hash());
+        shard.entries.pop_back();
+    }
+
+    shard.entries.push_front({ tx, position, height });
+    shard.lookup.emplace(hash, shard.entries.begin());
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void transaction_cache::confirm(const hash_digest& hash, size_t position,
+    size_t height)
+{
+    auto& shard = get_shard(hash);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(shard.mutex);
+    const auto it = shard.lookup.find(hash);
+
+    if (it == shard.lookup.end())
+        return;
+
+    it->second->position = position;
+    it->second->height = height;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool transaction_cache::get(transaction_const_ptr& out_tx,
+    size_t& out_position, size_t& out_height, const hash_digest& hash) const
+{
+    auto& shard = get_shard(hash);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(shard.mutex);
+    const auto it = shard.lookup.find(hash);
+
+    if (it == shard.lookup.end())
+    {
+        ++misses_;
+        return false;
+    }
+
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    out_tx = it->second->tx;
+    out_position = it->second->position;
+    out_height = it->second->height;
+    ++hits_;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool transaction_cache::exists(const hash_digest& hash) const
+{
+    auto& shard = get_shard(hash);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shard.mutex.lock_shared();
+    const auto found = shard.lookup.find(hash) != shard.lookup.end();
+    shard.mutex.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return found;
+}
+
+void transaction_cache::remove(const hash_digest& hash)
+{
+    auto& shard = get_shard(hash);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(shard.mutex);
+    const auto it = shard.lookup.find(hash);
+
+    if (it == shard.lookup.end())
+        return;
+
+    shard.entries.erase(it->second);
+    shard.lookup.erase(it);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void transaction_cache::clear()
+{
+    for (auto& shard: shards_)
+    {
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        unique_lock lock(shard.mutex);
+        shard.entries.clear();
+        shard.lookup.clear();
+        ///////////////////////////////////////////////////////////////////////
+    }
+}
+
+// private
+// Hashes are uniformly distributed, so the last byte selects the shard.
+size_t transaction_cache::index(const hash_digest& hash)
+{
+    return hash.back() % shard_count;
+}
+
+// private
+transaction_cache::shard& transaction_cache::get_shard(
+    const hash_digest& hash) const
+{
+    return shards_[index(hash)];
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
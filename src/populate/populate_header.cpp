@@ -39,28 +39,24 @@ void populate_header::populate(header_branch::ptr branch,
     result_handler&& handler) const
 {
     // The header could not be connected to the header index.
-    if (!set_branch_state(branch))
-    {
-        handler(error::orphan_block);
-        return;
-    }
+    handler(set_branch_state(branch) ? error::success : error::orphan_block);
+}
 
-    const auto& header = *branch->top();
+code populate_header::populate(const chain::header& header) const
+{
+    BITCOIN_ASSERT(header.metadata.state);
     fast_chain_.populate_header(header);
 
     // TODO: ensure there is no need to set header state or index here.
     if (header.metadata.exists)
-    {
-        handler(error::duplicate_block);
-        return;
-    }
+        return error::duplicate_block;
 
     // HACK: allows header collection to carry median_time_past to store.
     header.metadata.median_time_past = header.metadata.state->
         median_time_past();
 
     // If there is an existing full block validation error return it.
-    handler(header.metadata.error);
+    return header.metadata.error;
 }
 
 // private
@@ -32,6 +32,17 @@ settings::settings()
     minimum_output_satoshis(500),
     notify_limit_hours(24),
     reorganization_limit(0),
+    block_cache_capacity(8),
+    transaction_cache_capacity(10000),
+    hash_filter_capacity(0),
+    index_spends(false),
+    spend_table_buckets(10000000),
+    query_threads(0),
+    query_queue_limit(1000),
+    block_read_ahead(8),
+    flush_batch_blocks(0),
+    flush_batch_bytes(0),
+    flush_batch_milliseconds(0),
     difficult(true),
     retarget(true),
     bip16(true),
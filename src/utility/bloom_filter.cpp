@@ -0,0 +1,237 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/utility/bloom_filter.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+using namespace bc::chain;
+using namespace bc::machine;
+
+// BIP37 seeds each hash function by its index times this, plus the tweak.
+static const uint32_t seed_multiplier = 0xfba4c795;
+
+static inline uint32_t rotate_left(uint32_t value, uint32_t bits)
+{
+    return (value << bits) | (value >> (32u - bits));
+}
+
+// Murmur3 of the element for each seed, in one pass over the element. The
+// block mix is independent of the seed, so it is computed once per block and
+// only the short lane update is repeated for each seed.
+static void murmur3_lanes(uint32_t* hashes, const uint32_t* seeds, size_t count,
+    const data_slice& data)
+{
+    static const uint32_t c1 = 0xcc9e2d51;
+    static const uint32_t c2 = 0x1b873593;
+
+    const auto size = data.size();
+    const auto blocks = size / 4u;
+    const auto bytes = data.data();
+    std::copy(seeds, seeds + count, hashes);
+
+    for (size_t block = 0; block < blocks; ++block)
+    {
+        auto key = from_little_endian_unsafe<uint32_t>(bytes + 4u * block);
+        key = rotate_left(key * c1, 15) * c2;
+
+        for (size_t lane = 0; lane < count; ++lane)
+            hashes[lane] = rotate_left(hashes[lane] ^ key, 13) * 5u +
+                0xe6546b64;
+    }
+
+    const auto tail = bytes + 4u * blocks;
+    uint32_t key = 0;
+
+    switch (size & 3u)
+    {
+        case 3:
+            key ^= uint32_t(tail[2]) << 16;
+            // fall through
+        case 2:
+            key ^= uint32_t(tail[1]) << 8;
+            // fall through
+        case 1:
+            key ^= uint32_t(tail[0]);
+            key = rotate_left(key * c1, 15) * c2;
+
+            for (size_t lane = 0; lane < count; ++lane)
+                hashes[lane] ^= key;
+    }
+
+    for (size_t lane = 0; lane < count; ++lane)
+    {
+        auto hash = hashes[lane] ^ static_cast<uint32_t>(size);
+        hash = (hash ^ (hash >> 16)) * 0x85ebca6b;
+        hash = (hash ^ (hash >> 13)) * 0xc2b2ae35;
+        hashes[lane] = hash ^ (hash >> 16);
+    }
+}
+
+uint32_t bloom_filter::murmur3(uint32_t seed, const data_slice& data)
+{
+    uint32_t hash;
+    murmur3_lanes(&hash, &seed, 1, data);
+    return hash;
+}
+
+bloom_filter::bloom_filter(const data_chunk& data, uint32_t hash_functions,
+    uint32_t tweak, uint8_t flags)
+  : data_(data),
+    seeds_(std::min(size_t(hash_functions), size_t(max_hash_functions))),
+    flags_(flags),
+    full_(false),
+    empty_(false)
+{
+    for (size_t index = 0; index < seeds_.size(); ++index)
+        seeds_[index] = static_cast<uint32_t>(index) * seed_multiplier + tweak;
+
+    update_empty_full();
+}
+
+bool bloom_filter::contains(const data_slice& element) const
+{
+    if (full_)
+        return true;
+
+    if (empty_)
+        return false;
+
+    uint32_t indexes[max_hash_functions];
+    bits(indexes, element);
+
+    for (size_t index = 0; index < seeds_.size(); ++index)
+        if ((data_[indexes[index] >> 3] & (1u << (indexes[index] & 7u))) == 0)
+            return false;
+
+    return true;
+}
+
+void bloom_filter::insert(const data_slice& element)
+{
+    if (full_)
+        return;
+
+    uint32_t indexes[max_hash_functions];
+    bits(indexes, element);
+
+    for (size_t index = 0; index < seeds_.size(); ++index)
+        data_[indexes[index] >> 3] |= (1u << (indexes[index] & 7u));
+
+    empty_ = false;
+}
+
+// Outputs are matched first, so that outpoints inserted for an output of the
+// transaction are present when its inputs are matched.
+bool bloom_filter::match(const transaction& tx)
+{
+    if (full_)
+        return true;
+
+    if (empty_)
+        return false;
+
+    const auto hash = tx.hash();
+    const auto outputs = match_outputs(tx);
+    return contains(hash) || outputs || match_inputs(tx);
+}
+
+// private
+void bloom_filter::bits(uint32_t* out_bits, const data_slice& element) const
+{
+    const auto count = seeds_.size();
+    const auto size = static_cast<uint32_t>(data_.size() * 8u);
+    murmur3_lanes(out_bits, seeds_.data(), count, element);
+
+    for (size_t index = 0; index < count; ++index)
+        out_bits[index] %= size;
+}
+
+// private
+// All outputs are matched, as each matched output may insert its outpoint.
+bool bloom_filter::match_outputs(const transaction& tx)
+{
+    auto matched = false;
+    const auto& outputs = tx.outputs();
+    const auto update = flags_ & update_mask;
+
+    for (uint32_t index = 0; index < outputs.size(); ++index)
+    {
+        const auto& script = outputs[index].script();
+
+        for (const auto& operation: script.operations())
+        {
+            const auto& data = operation.data();
+
+            if (data.empty() || !contains(data))
+                continue;
+
+            matched = true;
+            const auto pattern = script.pattern();
+
+            if (update == update_all || (update == update_p2pubkey_only &&
+                (pattern == script_pattern::pay_public_key ||
+                pattern == script_pattern::pay_multisig)))
+                insert(output_point{ tx.hash(), index }.to_data());
+
+            break;
+        }
+    }
+
+    return matched;
+}
+
+// private
+bool bloom_filter::match_inputs(const transaction& tx) const
+{
+    for (const auto& input: tx.inputs())
+    {
+        if (contains(input.previous_output().to_data()))
+            return true;
+
+        for (const auto& operation: input.script().operations())
+        {
+            const auto& data = operation.data();
+
+            if (!data.empty() && contains(data))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+// private
+// As in the satoshi client, the states are computed on load and not rescanned
+// after insertion. A filter of no bytes is full, so it matches everything.
+void bloom_filter::update_empty_full()
+{
+    const auto set = [](uint8_t byte) { return byte == 0xff; };
+    const auto clear = [](uint8_t byte) { return byte == 0x00; };
+    full_ = std::all_of(data_.begin(), data_.end(), set);
+    empty_ = std::all_of(data_.begin(), data_.end(), clear);
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
@@ -0,0 +1,494 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/utility/chain_columns.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+// The table is doubled when half full, so probe sequences remain short.
+static constexpr size_t minimum_slots = 1024;
+static constexpr uint32_t empty_slot = 0;
+
+chain_columns::chain_columns()
+  : slots_(minimum_slots, empty_slot)
+{
+}
+
+size_t chain_columns::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto count = hashes_.size();
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return count;
+}
+
+bool chain_columns::empty() const
+{
+    return size() == 0;
+}
+
+bool chain_columns::top(size_t& out_height) const
+{
+    const auto count = size();
+
+    if (count == 0)
+        return false;
+
+    out_height = count - 1u;
+    return true;
+}
+
+bool chain_columns::get_block_hash(hash_digest& out_hash, size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto found = height < hashes_.size();
+
+    if (found)
+        out_hash = hashes_[height];
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return found;
+}
+
+bool chain_columns::get_bits(uint32_t& out_bits, size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto found = height < bits_.size();
+
+    if (found)
+        out_bits = bits_[height];
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return found;
+}
+
+bool chain_columns::get_timestamp(uint32_t& out_timestamp,
+    size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto found = height < timestamps_.size();
+
+    if (found)
+        out_timestamp = timestamps_[height];
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return found;
+}
+
+bool chain_columns::get_version(uint32_t& out_version, size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto found = height < versions_.size();
+
+    if (found)
+        out_version = versions_[height];
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return found;
+}
+
+bool chain_columns::get_median_time_past(uint32_t& out_time,
+    size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto found = height < median_time_pasts_.size();
+
+    if (found)
+        out_time = median_time_pasts_[height];
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return found;
+}
+
+bool chain_columns::get_state(uint8_t& out_state, size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto found = height < states_.size();
+
+    if (found)
+        out_state = states_[height];
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return found;
+}
+
+bool chain_columns::get_cumulative_work(uint256_t& out_work,
+    size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto found = height < works_.size();
+
+    if (found)
+        out_work = works_[height];
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return found;
+}
+
+// The work column is a prefix sum, so this is a single subtraction.
+bool chain_columns::get_work(uint256_t& out_work, size_t above_height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto found = !works_.empty();
+
+    if (found && above_height < works_.size() - 1u)
+        out_work = works_.back() - works_[above_height];
+    else if (found)
+        out_work = 0;
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return found;
+}
+
+// Proof is always positive, so cumulative work is strictly increasing.
+bool chain_columns::get_height(size_t& out_height,
+    const uint256_t& cumulative_work) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto it = std::lower_bound(works_.begin(), works_.end(),
+        cumulative_work);
+    const auto found = it != works_.end();
+
+    if (found)
+        out_height = static_cast<size_t>(std::distance(works_.begin(), it));
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return found;
+}
+
+bool chain_columns::find(size_t& out_height, uint8_t& out_state,
+    const hash_digest& block_hash) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto entry = slots_[slot(block_hash)];
+    const auto found = entry != empty_slot;
+
+    if (found)
+    {
+        out_height = entry - 1u;
+        out_state = states_[out_height];
+    }
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return found;
+}
+
+bool chain_columns::exists(const hash_digest& block_hash) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto found = slots_[slot(block_hash)] != empty_slot;
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return found;
+}
+
+// protected
+// Block hashes are uniformly distributed, so any eight bytes are a hash.
+size_t chain_columns::home(const hash_digest& block_hash) const
+{
+    uint64_t value;
+    std::memcpy(&value, block_hash.data(), sizeof(value));
+    return static_cast<size_t>(value) & (slots_.size() - 1u);
+}
+
+// protected
+// The slot of the hash, or the empty slot that terminates its probe.
+// Guarded by caller.
+size_t chain_columns::slot(const hash_digest& block_hash) const
+{
+    const auto mask = slots_.size() - 1u;
+    auto index = home(block_hash);
+
+    while (slots_[index] != empty_slot &&
+        hashes_[slots_[index] - 1u] != block_hash)
+        index = (index + 1u) & mask;
+
+    return index;
+}
+
+// protected
+// Guarded by caller, the hash must already be in the hash column.
+void chain_columns::insert(size_t height)
+{
+    if (2u * (hashes_.size() + 1u) > slots_.size())
+        rehash(2u * slots_.size());
+
+    slots_[slot(hashes_[height])] = static_cast<uint32_t>(height + 1u);
+}
+
+// protected
+// Backward shift deletion preserves the probe sequences of linear probing.
+// Guarded by caller, the hash must still be in the hash column.
+void chain_columns::erase(size_t height)
+{
+    const auto mask = slots_.size() - 1u;
+    auto hole = slot(hashes_[height]);
+    auto next = hole;
+
+    if (slots_[hole] == empty_slot)
+        return;
+
+    slots_[hole] = empty_slot;
+
+    while (slots_[next = (next + 1u) & mask] != empty_slot)
+    {
+        const auto start = home(hashes_[slots_[next] - 1u]);
+
+        // The entry moves only if its home is not cyclically in (hole, next].
+        const auto stays = hole <= next ?
+            (hole < start && start <= next) :
+            (hole < start || start <= next);
+
+        if (!stays)
+        {
+            slots_[hole] = slots_[next];
+            slots_[next] = empty_slot;
+            hole = next;
+        }
+    }
+}
+
+// protected
+// Guarded by caller.
+void chain_columns::rehash(size_t capacity)
+{
+    capacity = std::max(capacity, minimum_slots);
+
+    // Capacity remains a power of two, so the mask is capacity less one.
+    while (capacity < 2u * (hashes_.size() + 1u))
+        capacity *= 2u;
+
+    slots_.assign(capacity, empty_slot);
+
+    for (size_t height = 0; height < hashes_.size(); ++height)
+        slots_[slot(hashes_[height])] = static_cast<uint32_t>(height + 1u);
+}
+
+// protected
+// The median of the timestamps of up to 11 preceding headers (bip113).
+// Guarded by caller.
+uint32_t chain_columns::median_time_past() const
+{
+    const auto count = std::min<size_t>(timestamps_.size(),
+        median_time_past_interval);
+
+    if (count == 0)
+        return 0;
+
+    std::vector<uint32_t> times(timestamps_.end() - count, timestamps_.end());
+    const auto middle = times.begin() + (count / 2u);
+    std::nth_element(times.begin(), middle, times.end());
+    return *middle;
+}
+
+// A single pass over the state and populated columns, for downloading.
+void chain_columns::get_schedule(config::checkpoint::list& out_empty,
+    config::checkpoint::list& out_populated, size_t from_height,
+    size_t count, uint8_t empty_excluded, uint8_t populated_excluded) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+
+    const auto end = std::min(states_.size(), from_height +
+        std::min(count, states_.size()));
+
+    for (auto height = from_height; height < end; ++height)
+    {
+        if (populated_[height])
+        {
+            if ((states_[height] & populated_excluded) == 0)
+                out_populated.emplace_back(hashes_[height], height);
+        }
+        else if ((states_[height] & empty_excluded) == 0)
+        {
+            out_empty.emplace_back(hashes_[height], height);
+        }
+    }
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void chain_columns::push(const chain::header& header, uint8_t state)
+{
+    const auto hash = header.hash();
+    auto work = header.proof();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (!works_.empty())
+        work += works_.back();
+
+    // The median time past is computed before the header is appended.
+    median_time_pasts_.push_back(median_time_past());
+    hashes_.push_back(hash);
+    insert(hashes_.size() - 1u);
+    bits_.push_back(header.bits());
+    timestamps_.push_back(header.timestamp());
+    versions_.push_back(header.version());
+    states_.push_back(state);
+    populated_.push_back(false);
+    works_.push_back(work);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool chain_columns::set_state(size_t height, uint8_t state)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (height >= states_.size())
+        return false;
+
+    states_[height] = state;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool chain_columns::set_populated(size_t height, bool populated)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (height >= populated_.size())
+        return false;
+
+    populated_[height] = populated;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The hash is compared under the same lock, so a concurrent truncation
+// cannot cause the state of another header to be set.
+bool chain_columns::set_block(const hash_digest& block_hash, size_t height,
+    uint8_t state, bool populated)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (height >= hashes_.size() || hashes_[height] != block_hash)
+        return false;
+
+    states_[height] = state;
+    populated_[height] = populated;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void chain_columns::truncate(size_t height)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (height >= hashes_.size())
+        return;
+
+    // Rebuild the table if most of it is removed, otherwise erase entries.
+    if (height < hashes_.size() - height)
+    {
+        hashes_.resize(height);
+        rehash(minimum_slots);
+    }
+    else
+    {
+        for (auto index = hashes_.size(); index > height; --index)
+            erase(index - 1u);
+
+        hashes_.resize(height);
+    }
+
+    bits_.resize(height);
+    timestamps_.resize(height);
+    versions_.resize(height);
+    median_time_pasts_.resize(height);
+    states_.resize(height);
+    populated_.resize(height);
+    works_.resize(height);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void chain_columns::clear()
+{
+    truncate(0);
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
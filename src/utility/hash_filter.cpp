@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/utility/hash_filter.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+// Blocks are a power of two in number, so that a mask selects the block.
+static size_t block_count(size_t capacity, size_t bits_per_entry,
+    size_t bits_per_block)
+{
+    if (capacity == 0)
+        return 0;
+
+    size_t count = 1;
+    const auto bits = capacity * bits_per_entry;
+
+    while (count * bits_per_block < bits)
+        count <<= 1;
+
+    return count;
+}
+
+hash_filter::hash_filter(size_t capacity)
+  : words_(block_count(capacity, bits_per_entry, words_per_block * 64u) *
+        words_per_block),
+    mask_(words_.empty() ? 0 : words_.size() / words_per_block - 1u)
+{
+}
+
+void hash_filter::add(const hash_digest& hash)
+{
+    if (words_.empty())
+        return;
+
+    const auto first = block(hash) * words_per_block;
+
+    for (size_t index = 0; index < bits_per_hash; ++index)
+    {
+        const auto bit_index = bit(hash, index);
+        words_[first + (bit_index >> 6)].fetch_or(uint64_t(1) <<
+            (bit_index & 63u), std::memory_order_relaxed);
+    }
+}
+
+bool hash_filter::contains(const hash_digest& hash) const
+{
+    if (words_.empty())
+        return true;
+
+    const auto first = block(hash) * words_per_block;
+
+    for (size_t index = 0; index < bits_per_hash; ++index)
+    {
+        const auto bit_index = bit(hash, index);
+        const auto value = words_[first + (bit_index >> 6)].load(
+            std::memory_order_relaxed);
+
+        if ((value & (uint64_t(1) << (bit_index & 63u))) == 0)
+            return false;
+    }
+
+    return true;
+}
+
+// private
+// Hashes are uniformly distributed, so the first bytes select the block.
+size_t hash_filter::block(const hash_digest& hash) const
+{
+    return static_cast<size_t>(from_little_endian_unsafe<uint64_t>(
+        hash.begin())) & mask_;
+}
+
+// private
+// Each bit within the 512 bit block is selected by two subsequent bytes.
+uint64_t hash_filter::bit(const hash_digest& hash, size_t index)
+{
+    const auto offset = sizeof(uint64_t) + 2u * index;
+    return from_little_endian_unsafe<uint16_t>(hash.begin() + offset) & 511u;
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/utility/partial_merkle_tree.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+// The hashes and matches of each level are computed once, bottom up, so the
+// walk reads each node without recomputing the subtree below it.
+partial_merkle_tree::partial_merkle_tree(const hash_list& leaves,
+    const std::vector<bool>& matches)
+  : bits_(0)
+{
+    if (leaves.empty() || matches.size() != leaves.size())
+        return;
+
+    std::vector<hash_list> hashes{ leaves };
+    std::vector<match_list> matched{ matches };
+
+    while (hashes.back().size() > 1u)
+    {
+        const auto& below = hashes.back();
+        const auto& below_matched = matched.back();
+        const auto width = (below.size() + 1u) / 2u;
+        hash_list level(width);
+        match_list level_matched(width);
+
+        // An odd last node is paired with itself.
+        for (size_t index = 0; index < width; ++index)
+        {
+            const auto left = 2u * index;
+            const auto right = std::min(left + 1u, below.size() - 1u);
+            level[index] = bitcoin_hash(build_chunk({ below[left],
+                below[right] }));
+            level_matched[index] = below_matched[left] ||
+                below_matched[right];
+        }
+
+        hashes.push_back(std::move(level));
+        matched.push_back(std::move(level_matched));
+    }
+
+    walk(hashes.size() - 1u, 0, hashes, matched);
+}
+
+const hash_list& partial_merkle_tree::hashes() const
+{
+    return hashes_;
+}
+
+const data_chunk& partial_merkle_tree::flags() const
+{
+    return flags_;
+}
+
+// private
+// A node above a match is descended, any other node is pruned to its hash.
+void partial_merkle_tree::walk(size_t level, size_t index,
+    const std::vector<hash_list>& hashes,
+    const std::vector<match_list>& matches)
+{
+    const auto matched = matches[level][index];
+
+    if (bits_ % 8u == 0)
+        flags_.push_back(0x00);
+
+    if (matched)
+        flags_.back() |= (1u << (bits_ % 8u));
+
+    ++bits_;
+
+    if (level == 0 || !matched)
+    {
+        hashes_.push_back(hashes[level][index]);
+        return;
+    }
+
+    const auto left = 2u * index;
+    walk(level - 1u, left, hashes, matches);
+
+    if (left + 1u < hashes[level - 1u].size())
+        walk(level - 1u, left + 1u, hashes, matches);
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
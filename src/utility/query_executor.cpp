@@ -0,0 +1,186 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/utility/query_executor.hpp>
+
+#include <cstddef>
+#include <future>
+#include <thread>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+#define NAME "query_executor"
+
+query_executor::query_executor(threadpool& pool, const limits::list& classes)
+  : dispatch_(pool, NAME),
+    stopped_(false),
+    complete_(idle_.get_future().share())
+{
+    classes_.reserve(classes.size());
+
+    for (const auto& limit: classes)
+        classes_.push_back({ limit, 0, {} });
+}
+
+size_t query_executor::pending(size_t query_class) const
+{
+    BITCOIN_ASSERT(query_class < classes_.size());
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto count = classes_[query_class].queue.size();
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return count;
+}
+
+bool query_executor::execute(size_t query_class, const query& handler)
+{
+    BITCOIN_ASSERT(query_class < classes_.size());
+
+    // Without threads the query executes on the caller's thread.
+    if (dispatch_.size() == 0)
+    {
+        handler();
+        return true;
+    }
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+    auto& state = classes_[query_class];
+
+    if (stopped_ || (state.running == state.limit.concurrency &&
+        state.queue.size() == state.limit.queue))
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return false;
+    }
+
+    if (state.running == state.limit.concurrency)
+    {
+        state.queue.push_back(handler);
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return true;
+    }
+
+    ++state.running;
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    dispatch_.concurrent(&query_executor::run, this, query_class, handler);
+    return true;
+}
+
+// The pool may only be shut down once stopped, as a query that is posted but
+// not yet run would otherwise be lost (and its handler never invoked).
+bool query_executor::stop()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+    stopped_ = true;
+
+    // A query cannot wait on itself, so it is left to a subsequent stop.
+    if (executing_.count(std::this_thread::get_id()) != 0)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return false;
+    }
+
+    if (idle())
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return true;
+    }
+
+    const auto complete = complete_;
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // The last query to complete signals, after draining each class queue.
+    complete.wait();
+    return true;
+}
+
+// private
+// The next query of the class is posted, not run in line, so that the pool
+// alternates between classes.
+void query_executor::run(size_t query_class, query handler)
+{
+    const auto thread = std::this_thread::get_id();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+    executing_.insert(thread);
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    handler();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+    executing_.erase(thread);
+    auto& state = classes_[query_class];
+
+    if (state.queue.empty())
+    {
+        --state.running;
+
+        // Signal waiting stops once no query remains.
+        if (stopped_ && idle())
+            idle_.set_value();
+
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    auto next = std::move(state.queue.front());
+    state.queue.pop_front();
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    dispatch_.concurrent(&query_executor::run, this, query_class,
+        std::move(next));
+}
+
+// private
+// Guarded by caller, a class with queued queries is always running.
+bool query_executor::idle() const
+{
+    for (const auto& state: classes_)
+        if (state.running != 0)
+            return false;
+
+    return true;
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
@@ -0,0 +1,383 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/utility/spend_index.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+// File: [buckets:8][rows:8][size:8][height:8][bucket:8]...[row]...
+// Row: [key:8][next:8][height:4][position:4][input:4]
+// Links are one-based row numbers, with zero terminating a chain, so that a
+// new (sparse) file extension is a table of empty buckets.
+static const uint64_t link_size = sizeof(uint64_t);
+static const uint64_t header_size = 4 * sizeof(uint64_t);
+static const uint64_t row_size = 2 * sizeof(uint64_t) + 3 * sizeof(uint32_t);
+static const uint64_t uncommitted = max_uint64;
+
+// The table grows as the store tables do, by half of its size.
+static const size_t expansion = 50;
+
+spend_index::spend_index(const boost::filesystem::path& filename,
+    size_t buckets)
+  : filename_(filename),
+    buckets_(buckets == 0 ? 1 : buckets),
+    file_(filename, header_size + buckets_ * link_size, expansion),
+    opened_(false),
+    writing_(false),
+    rows_(0),
+    size_(0),
+    height_(uncommitted)
+{
+}
+
+bool spend_index::open()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (opened_)
+        return true;
+
+    // An unreadable or differently-bucketed file is replaced with an empty
+    // and uncommitted index, which the caller then populates.
+    opened_ = (boost::filesystem::exists(filename_) && file_.open() &&
+        read_header()) || create();
+
+    return opened_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool spend_index::close()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (!opened_)
+        return true;
+
+    // The indexed height is consistent between writes, so it is committed.
+    opened_ = false;
+    writing_ = false;
+    return write_header() && file_.flush() && file_.close();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t spend_index::height() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto height = height_;
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return height == uncommitted ? max_size_t : static_cast<size_t>(height);
+}
+
+void spend_index::set_height(size_t height)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    height_ = height;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The uncommitted header is flushed before any row is written.
+bool spend_index::begin_write()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (writing_)
+        return true;
+
+    writing_ = true;
+    return write_header() && file_.flush();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool spend_index::end_write(size_t height)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    height_ = height;
+    writing_ = false;
+    return write_header() && file_.flush();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t spend_index::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto count = size_;
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return static_cast<size_t>(count);
+}
+
+void spend_index::get(spender::list& out_spenders,
+    const chain::output_point& outpoint) const
+{
+    const auto value = key(outpoint);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    read_spenders(out_spenders, value);
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void spend_index::add(const chain::output_point& outpoint,
+    const spender& spend)
+{
+    const auto value = key(outpoint);
+    const auto bucket = bucket_offset(value);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    // Rows are appended and pushed onto the front of the bucket chain.
+    const auto link = rows_ + 1u;
+    const auto offset = row_offset(link);
+    const auto memory = file_.resize(offset + row_size);
+    const auto buffer = memory->buffer();
+    write_row(buffer, offset, { value, read_link(buffer, bucket), spend });
+    write_link(buffer, bucket, link);
+    rows_ = link;
+    ++size_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void spend_index::remove(const chain::output_point& outpoint,
+    size_t above_height)
+{
+    const auto value = key(outpoint);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    const auto memory = file_.access();
+    const auto buffer = memory->buffer();
+
+    // Removed rows are unlinked from the chain, their space is not reused.
+    auto previous = bucket_offset(value);
+
+    for (auto link = read_link(buffer, previous); link != 0;)
+    {
+        const auto current = read_row(buffer, row_offset(link));
+
+        if (current.key == value && current.spend.height > above_height)
+        {
+            write_link(buffer, previous, current.next);
+            --size_;
+        }
+        else
+        {
+            previous = row_offset(link) + sizeof(uint64_t);
+        }
+
+        link = current.next;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool spend_index::clear()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    opened_ = create();
+    return opened_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// Hashes are uniformly distributed, so the index is mixed into eight bytes.
+uint64_t spend_index::key(const chain::output_point& outpoint)
+{
+    const auto& hash = outpoint.hash();
+    const auto prefix = from_little_endian_unsafe<uint64_t>(hash.begin());
+    return prefix ^ (uint64_t(outpoint.index()) * 0x9e3779b97f4a7c15);
+}
+
+// private
+// Replace the file with an empty and uncommitted table of zeroed buckets.
+// The map requires a non-empty file, as does each store table on create.
+bool spend_index::create()
+{
+    if (!file_.closed() && !file_.close())
+        return false;
+
+    boost::system::error_code ec;
+    boost::filesystem::remove(filename_, ec);
+
+    {
+        bc::ofstream file(filename_.string());
+        file.put(0);
+
+        if (!file.good())
+            return false;
+    }
+
+    rows_ = 0;
+    size_ = 0;
+    height_ = uncommitted;
+    writing_ = false;
+
+    if (!file_.open())
+        return false;
+
+    // The file is extended over the buckets, and is zero filled (sparse).
+    if (!file_.resize(header_size + buckets_ * link_size))
+        return false;
+
+    return write_header() && file_.flush();
+}
+
+// private
+bool spend_index::read_header()
+{
+    if (file_.size() < header_size + buckets_ * link_size)
+        return false;
+
+    const auto memory = file_.access();
+    const auto buffer = memory->buffer();
+
+    if (from_little_endian_unsafe<uint64_t>(&buffer[0]) != buckets_)
+        return false;
+
+    rows_ = from_little_endian_unsafe<uint64_t>(&buffer[8]);
+    size_ = from_little_endian_unsafe<uint64_t>(&buffer[16]);
+    height_ = from_little_endian_unsafe<uint64_t>(&buffer[24]);
+    return file_.size() >= row_offset(rows_ + 1u);
+}
+
+// private
+bool spend_index::write_header()
+{
+    const auto header = build_chunk(
+    {
+        to_little_endian(buckets_),
+        to_little_endian(rows_),
+        to_little_endian(size_),
+        to_little_endian(writing_ ? uncommitted : height_)
+    });
+
+    const auto memory = file_.access();
+    std::copy(header.begin(), header.end(), memory->buffer());
+    return true;
+}
+
+// private
+// Guarded by the caller.
+void spend_index::read_spenders(spender::list& out_spenders,
+    uint64_t key) const
+{
+    const auto memory = file_.access();
+    const auto buffer = memory->buffer();
+
+    for (auto link = read_link(buffer, bucket_offset(key)); link != 0;)
+    {
+        const auto current = read_row(buffer, row_offset(link));
+
+        if (current.key == key)
+            out_spenders.push_back(current.spend);
+
+        link = current.next;
+    }
+}
+
+// private
+uint64_t spend_index::bucket_offset(uint64_t key) const
+{
+    return header_size + (key % buckets_) * link_size;
+}
+
+// private
+uint64_t spend_index::row_offset(uint64_t link) const
+{
+    return header_size + buckets_ * link_size + (link - 1) * row_size;
+}
+
+// private
+uint64_t spend_index::read_link(const uint8_t* buffer, uint64_t offset)
+{
+    return from_little_endian_unsafe<uint64_t>(buffer + offset);
+}
+
+// private
+void spend_index::write_link(uint8_t* buffer, uint64_t offset, uint64_t link)
+{
+    const auto data = to_little_endian(link);
+    std::copy(data.begin(), data.end(), buffer + offset);
+}
+
+// private
+spend_index::row spend_index::read_row(const uint8_t* buffer,
+    uint64_t offset)
+{
+    const auto data = buffer + offset;
+
+    return
+    {
+        from_little_endian_unsafe<uint64_t>(&data[0]),
+        from_little_endian_unsafe<uint64_t>(&data[8]),
+        {
+            from_little_endian_unsafe<uint32_t>(&data[16]),
+            from_little_endian_unsafe<uint32_t>(&data[20]),
+            from_little_endian_unsafe<uint32_t>(&data[24])
+        }
+    };
+}
+
+// private
+void spend_index::write_row(uint8_t* buffer, uint64_t offset,
+    const row& value)
+{
+    const auto data = build_chunk(
+    {
+        to_little_endian(value.key),
+        to_little_endian(value.next),
+        to_little_endian(value.spend.height),
+        to_little_endian(value.spend.position),
+        to_little_endian(value.spend.input)
+    });
+
+    std::copy(data.begin(), data.end(), buffer + offset);
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
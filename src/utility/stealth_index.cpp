@@ -0,0 +1,359 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/utility/stealth_index.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+// Rows are tested in runs of this size, each run producing a match bitmap.
+static constexpr size_t run_size = 64;
+static constexpr size_t prefix_bits = 32;
+
+// File: [rows:8][top:8][row]...
+// Row: [prefix:4][height:4][ephemeral_key:32][public_key_hash:20][tx_hash:32]
+static const uint64_t header_size = 2 * sizeof(uint64_t);
+static const uint64_t row_size = 2 * sizeof(uint32_t) + 2 * hash_size +
+    short_hash_size;
+static const uint64_t uncommitted = max_uint64;
+
+// The file grows as the store tables do, by half of its size.
+static const size_t expansion = 50;
+
+stealth_index::stealth_index(const boost::filesystem::path& filename)
+  : filename_(filename),
+    file_(filename, header_size, expansion),
+    opened_(false),
+    writing_(false),
+    top_(max_size_t)
+{
+}
+
+bool stealth_index::open()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (opened_)
+        return true;
+
+    // An unreadable file is replaced with an empty and uncommitted index,
+    // which the caller then populates.
+    opened_ = (boost::filesystem::exists(filename_) && file_.open() &&
+        load()) || create();
+
+    return opened_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool stealth_index::close()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (!opened_)
+        return true;
+
+    // The top is consistent between writes, so it is committed.
+    opened_ = false;
+    writing_ = false;
+    return write_header() && file_.flush() && file_.close();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t stealth_index::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto count = prefixes_.size();
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return count;
+}
+
+size_t stealth_index::top() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto top = top_;
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return top;
+}
+
+void stealth_index::set_top(size_t height)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    top_ = height;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The uncommitted header is flushed before any row is written.
+bool stealth_index::begin_write()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (writing_)
+        return true;
+
+    writing_ = true;
+    return write_header() && file_.flush();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool stealth_index::end_write(size_t height)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    top_ = height;
+    writing_ = false;
+    return write_header() && file_.flush();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void stealth_index::add(const record& record)
+{
+    BITCOIN_ASSERT(record.height <= max_uint32);
+    const auto height = static_cast<uint32_t>(record.height);
+    const auto row = build_chunk(
+    {
+        to_little_endian(record.prefix),
+        to_little_endian(height),
+        record.ephemeral_key,
+        record.public_key_hash,
+        record.transaction_hash
+    });
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    // Popped rows are overwritten, as the file holds rows in index order.
+    const auto offset = header_size + prefixes_.size() * row_size;
+    const auto memory = file_.resize(offset + row_size);
+    std::copy(row.begin(), row.end(), memory->buffer() + offset);
+
+    prefixes_.push_back(record.prefix);
+    heights_.push_back(height);
+    payloads_.push_back({ record.ephemeral_key, record.public_key_hash,
+        record.transaction_hash });
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Rows are in height order, so those above the height are at the back.
+// The file is not truncated, as its row count is written with the header.
+void stealth_index::remove(size_t above_height)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    while (!heights_.empty() && heights_.back() > above_height)
+    {
+        prefixes_.pop_back();
+        heights_.pop_back();
+        payloads_.pop_back();
+    }
+
+    if (top_ == max_size_t || top_ > above_height)
+        top_ = above_height;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The filter is a bit prefix of the little endian serialized prefix, so it
+// reduces to a value and mask over the integer prefix.
+void stealth_index::scan(record::list& out_records, const binary& filter,
+    size_t from_height) const
+{
+    if (filter.size() > prefix_bits)
+        return;
+
+    uint8_t value_bytes[sizeof(uint32_t)] = { 0 };
+    uint8_t mask_bytes[sizeof(uint32_t)] = { 0 };
+    const auto& blocks = filter.blocks();
+
+    for (size_t bit = 0; bit < filter.size(); ++bit)
+    {
+        const auto byte = bit / 8u;
+        const auto flag = static_cast<uint8_t>(0x80 >> (bit % 8u));
+        mask_bytes[byte] |= flag;
+        value_bytes[byte] |= (blocks[byte] & flag);
+    }
+
+    const auto value = from_little_endian_unsafe<uint32_t>(value_bytes);
+    const auto mask = from_little_endian_unsafe<uint32_t>(mask_bytes);
+    const auto minimum = static_cast<uint32_t>(
+        std::min<size_t>(from_height, max_uint32));
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    const auto count = prefixes_.size();
+    const auto prefixes = prefixes_.data();
+    const auto heights = heights_.data();
+
+    // Rows are in height order, so the scan starts at the first from height.
+    const auto start = static_cast<size_t>(std::distance(heights_.begin(),
+        std::lower_bound(heights_.begin(), heights_.end(), minimum)));
+
+    for (size_t first = start; first < count; first += run_size)
+    {
+        uint64_t matches = 0;
+        const auto size = std::min(run_size, count - first);
+
+        // Branchless, so that the compiler may test many rows at once.
+        for (size_t row = 0; row < size; ++row)
+            matches |= uint64_t(
+                ((prefixes[first + row] ^ value) & mask) == 0) << row;
+
+        for (size_t row = 0; matches != 0; ++row, matches >>= 1)
+        {
+            if ((matches & 1u) == 0)
+                continue;
+
+            const auto index = first + row;
+            const auto& payload = payloads_[index];
+            out_records.push_back({ prefixes[index], heights[index],
+                payload.ephemeral_key, payload.public_key_hash,
+                payload.transaction_hash });
+        }
+    }
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool stealth_index::clear()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    opened_ = create();
+    return opened_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// Replace the file with an empty and uncommitted index.
+// The map requires a non-empty file, as does each store table on create.
+bool stealth_index::create()
+{
+    if (!file_.closed() && !file_.close())
+        return false;
+
+    boost::system::error_code ec;
+    boost::filesystem::remove(filename_, ec);
+
+    {
+        bc::ofstream file(filename_.string());
+        file.put(0);
+
+        if (!file.good())
+            return false;
+    }
+
+    top_ = max_size_t;
+    writing_ = false;
+    prefixes_.clear();
+    heights_.clear();
+    payloads_.clear();
+
+    if (!file_.open())
+        return false;
+
+    if (!file_.resize(header_size))
+        return false;
+
+    return write_header() && file_.flush();
+}
+
+// private
+// Load the columns from the committed rows of the file.
+bool stealth_index::load()
+{
+    if (file_.size() < header_size)
+        return false;
+
+    const auto memory = file_.access();
+    const auto buffer = memory->buffer();
+    const auto rows = from_little_endian_unsafe<uint64_t>(&buffer[0]);
+    const auto top = from_little_endian_unsafe<uint64_t>(&buffer[8]);
+
+    if (file_.size() < header_size + rows * row_size)
+        return false;
+
+    prefixes_.resize(rows);
+    heights_.resize(rows);
+    payloads_.resize(rows);
+
+    for (uint64_t index = 0; index < rows; ++index)
+    {
+        const auto row = buffer + header_size + index * row_size;
+        auto& payload = payloads_[index];
+        prefixes_[index] = from_little_endian_unsafe<uint32_t>(&row[0]);
+        heights_[index] = from_little_endian_unsafe<uint32_t>(&row[4]);
+
+        auto data = row + 2 * sizeof(uint32_t);
+        std::copy_n(data, hash_size, payload.ephemeral_key.begin());
+        data += hash_size;
+        std::copy_n(data, short_hash_size, payload.public_key_hash.begin());
+        data += short_hash_size;
+        std::copy_n(data, hash_size, payload.transaction_hash.begin());
+    }
+
+    top_ = top == uncommitted ? max_size_t : static_cast<size_t>(top);
+    return true;
+}
+
+// private
+bool stealth_index::write_header()
+{
+    const uint64_t rows = prefixes_.size();
+    const uint64_t top = writing_ || top_ == max_size_t ? uncommitted : top_;
+    const auto header = build_chunk(
+    {
+        to_little_endian(rows),
+        to_little_endian(top)
+    });
+
+    const auto memory = file_.access();
+    std::copy(header.begin(), header.end(), memory->buffer());
+    return true;
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
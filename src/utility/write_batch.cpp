@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/utility/write_batch.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+write_batch::write_batch(size_t blocks, size_t bytes)
+  : blocks_limit_(blocks),
+    bytes_limit_(bytes),
+    open_(false),
+    blocks_(0),
+    bytes_(0)
+{
+}
+
+bool write_batch::enabled() const
+{
+    return blocks_limit_ != 0;
+}
+
+bool write_batch::begin()
+{
+    if (!enabled())
+        return false;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (open_)
+        return false;
+
+    open_ = true;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// A zero byte limit is unbounded. Writes of no blocks (e.g. headers) are
+// grouped, but only complete a group by bytes.
+bool write_batch::add(size_t blocks, size_t bytes)
+{
+    if (!enabled())
+        return true;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    open_ = true;
+    blocks_ += blocks;
+    bytes_ += bytes;
+
+    if (blocks_ < blocks_limit_ && (bytes_limit_ == 0 || bytes_ < bytes_limit_))
+        return false;
+
+    open_ = false;
+    blocks_ = 0;
+    bytes_ = 0;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool write_batch::reset()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    const auto pending = open_;
+    open_ = false;
+    blocks_ = 0;
+    bytes_ = 0;
+    return pending;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
@@ -81,7 +81,7 @@ code validate_header::check(header_const_ptr header) const
 void validate_header::accept(header_branch::ptr branch,
     result_handler handler) const
 {
-    // Populate header state for the top header (others are valid).
+    // Populate chain state for the top header (others are valid).
     header_populator_.populate(branch,
         std::bind(&validate_header::handle_populated,
             this, _1, branch, handler));
@@ -102,19 +102,23 @@ void validate_header::handle_populated(const code& ec,
         return;
     }
 
-    const auto& header = *branch->top();
+    handler(accept(*branch->top()));
+}
+
+// This is shared by the branch top and the successors of a header run.
+code validate_header::accept(const chain::header& header) const
+{
+    code error_code;
+
+    if ((error_code = header_populator_.populate(header)))
+        return error_code;
 
     // Skip validation if full block was validated (is valid at this point).
     if (header.metadata.validated)
-    {
-        handler(error::success);
-        return;
-    }
-
-    BITCOIN_ASSERT(header.metadata.state);
+        return error::success;
 
     // Run contextual header checks.
-    handler(header.accept());
+    return header.accept();
 }
 
 } // namespace blockchain
@@ -0,0 +1,177 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+BOOST_AUTO_TEST_SUITE(block_cache_tests)
+
+static block_const_ptr make_block(uint32_t id)
+{
+    return std::make_shared<const message::block>(
+        chain::header{ id, null_hash, null_hash, 0, 0, 0 },
+        chain::transaction::list{});
+}
+
+// add
+
+BOOST_AUTO_TEST_CASE(block_cache__add__zero_capacity__empty)
+{
+    block_cache instance(0);
+    instance.add(make_block(1));
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__add__twice__single)
+{
+    block_cache instance(42);
+    const auto block = make_block(1);
+    instance.add(block);
+    instance.add(block);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__add__same_hash__replaced)
+{
+    block_cache instance(42);
+    const auto block1 = make_block(1);
+    const auto block2 = make_block(1);
+    instance.add(block1);
+    instance.add(block2);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(instance.get(block1->hash()) == block2);
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__add__over_capacity__least_recent_evicted)
+{
+    block_cache instance(2);
+    const auto block1 = make_block(1);
+    const auto block2 = make_block(2);
+    const auto block3 = make_block(3);
+    instance.add(block1);
+    instance.add(block2);
+    instance.add(block3);
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+    BOOST_REQUIRE(!instance.get(block1->hash()));
+    BOOST_REQUIRE(instance.get(block2->hash()) == block2);
+    BOOST_REQUIRE(instance.get(block3->hash()) == block3);
+}
+
+// get
+
+BOOST_AUTO_TEST_CASE(block_cache__get__missing__null)
+{
+    block_cache instance(42);
+    BOOST_REQUIRE(!instance.get(null_hash));
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__get__read__retained_over_unread)
+{
+    block_cache instance(2);
+    const auto block1 = make_block(1);
+    const auto block2 = make_block(2);
+    const auto block3 = make_block(3);
+    instance.add(block1);
+    instance.add(block2);
+
+    // Reading the first block makes the second block least recent.
+    BOOST_REQUIRE(instance.get(block1->hash()) == block1);
+    instance.add(block3);
+    BOOST_REQUIRE(instance.get(block1->hash()) == block1);
+    BOOST_REQUIRE(!instance.get(block2->hash()));
+}
+
+// compact
+
+BOOST_AUTO_TEST_CASE(block_cache__set_compact__missing_block__not_cached)
+{
+    block_cache instance(42);
+    const auto block = make_block(1);
+    instance.set_compact(block->hash(), 2,
+        std::make_shared<message::compact_block>());
+    BOOST_REQUIRE(!instance.get_compact(block->hash(), 2));
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__set_compact__cached_block__cached)
+{
+    block_cache instance(42);
+    const auto block = make_block(1);
+    const auto compact = std::make_shared<message::compact_block>();
+    instance.add(block);
+    instance.set_compact(block->hash(), 2, compact);
+    BOOST_REQUIRE(instance.get_compact(block->hash(), 2) == compact);
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__get_compact__other_version__null)
+{
+    block_cache instance(42);
+    const auto block = make_block(1);
+    instance.add(block);
+    instance.set_compact(block->hash(), 2,
+        std::make_shared<message::compact_block>());
+    BOOST_REQUIRE(!instance.get_compact(block->hash(), 1));
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__set_compact__invalid_version__not_cached)
+{
+    block_cache instance(42);
+    const auto block = make_block(1);
+    instance.add(block);
+    instance.set_compact(block->hash(), 3,
+        std::make_shared<message::compact_block>());
+    BOOST_REQUIRE(!instance.get_compact(block->hash(), 3));
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__get_compact__evicted_block__null)
+{
+    block_cache instance(1);
+    const auto block1 = make_block(1);
+    instance.add(block1);
+    instance.set_compact(block1->hash(), 2,
+        std::make_shared<message::compact_block>());
+    instance.add(make_block(2));
+    BOOST_REQUIRE(!instance.get_compact(block1->hash(), 2));
+}
+
+// remove
+
+BOOST_AUTO_TEST_CASE(block_cache__remove__existing__removed)
+{
+    block_cache instance(42);
+    const auto block = make_block(1);
+    instance.add(block);
+    instance.remove(block->hash());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE(!instance.get(block->hash()));
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__clear__populated__empty)
+{
+    block_cache instance(42);
+    instance.add(make_block(1));
+    instance.add(make_block(2));
+    instance.clear();
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
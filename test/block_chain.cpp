@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <future>
+#include <memory>
+#include <bitcoin/blockchain.hpp>
+#include "utility.hpp"
+
+using namespace bc;
+using namespace bc::blockchain;
+using namespace bc::database;
+
+class block_chain_setup_fixture
+{
+public:
+    block_chain_setup_fixture()
+    {
+        log::initialize();
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(block_chain_tests, block_chain_setup_fixture)
+
+// Store the coinbase of the block as an unconfirmed (pool) transaction.
+static transaction_const_ptr store_unconfirmed(block_chain& instance,
+    block_const_ptr block)
+{
+    const auto tx = std::make_shared<const message::transaction>(
+        block->transactions().front());
+    tx->metadata.state = instance.next_confirmed_state();
+    return instance.store(tx) ? nullptr : tx;
+}
+
+// fetch_transaction
+
+static code fetch_transaction_result(block_chain& instance,
+    const hash_digest& hash, bool require_confirmed)
+{
+    std::promise<code> promise;
+    const auto handler = [&promise, &hash](code ec,
+        transaction_const_ptr result_tx, size_t, size_t)
+    {
+        if (ec)
+        {
+            promise.set_value(ec);
+            return;
+        }
+
+        const auto match = result_tx->hash() == hash;
+        promise.set_value(match ? error::success : error::operation_failed);
+    };
+
+    instance.fetch_transaction(hash, require_confirmed, true, handler);
+    return promise.get_future().get();
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__fetch_transaction__unconfirmed__success)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    const auto tx = store_unconfirmed(instance, NEW_BLOCK(1));
+    BOOST_REQUIRE(tx);
+    BOOST_REQUIRE(fetch_transaction_result(instance, tx->hash(), false) ==
+        error::success);
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__fetch_transaction__unconfirmed_require_confirmed__not_found)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    const auto tx = store_unconfirmed(instance, NEW_BLOCK(1));
+    BOOST_REQUIRE(tx);
+    BOOST_REQUIRE(fetch_transaction_result(instance, tx->hash(), true) ==
+        error::not_found);
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__fetch_transaction__not_exists__not_found)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    const auto block1 = NEW_BLOCK(1);
+    const auto hash = block1->transactions().front().hash();
+    BOOST_REQUIRE(fetch_transaction_result(instance, hash, false) ==
+        error::not_found);
+}
+
+// fetch_transaction_position
+
+static code fetch_transaction_position_result(block_chain& instance,
+    const hash_digest& hash, bool require_confirmed)
+{
+    std::promise<code> promise;
+    const auto handler = [&promise](code ec, size_t, size_t)
+    {
+        promise.set_value(ec);
+    };
+
+    instance.fetch_transaction_position(hash, require_confirmed, handler);
+    return promise.get_future().get();
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__fetch_transaction_position__unconfirmed__success)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    const auto tx = store_unconfirmed(instance, NEW_BLOCK(1));
+    BOOST_REQUIRE(tx);
+    BOOST_REQUIRE(fetch_transaction_position_result(instance, tx->hash(),
+        false) == error::success);
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__fetch_transaction_position__unconfirmed_require_confirmed__not_found)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    const auto tx = store_unconfirmed(instance, NEW_BLOCK(1));
+    BOOST_REQUIRE(tx);
+    BOOST_REQUIRE(fetch_transaction_position_result(instance, tx->hash(),
+        true) == error::not_found);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
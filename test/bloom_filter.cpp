@@ -0,0 +1,143 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+using namespace bc::chain;
+using namespace bc::machine;
+
+BOOST_AUTO_TEST_SUITE(bloom_filter_tests)
+
+static const data_chunk element{ 0x00, 0x11, 0x22, 0x33, 0x44 };
+
+static transaction make_transaction(const data_chunk& output_data)
+{
+    const operation::list operations{ operation(output_data) };
+    const script output_script(operations);
+    return transaction(1, 0, {}, { output(0, output_script) });
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__murmur3__empty__expected)
+{
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(0x00000000, data_chunk{}),
+        0x00000000u);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(0xfba4c795, data_chunk{}),
+        0x6a396f08u);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(0xffffffff, data_chunk{}),
+        0x81f16f39u);
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__murmur3__tail_lengths__expected)
+{
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(0, data_chunk{ 0x00 }),
+        0x514e28b7u);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(0xfba4c795, data_chunk{ 0x00 }),
+        0xea3f0b17u);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(0, data_chunk{ 0xff }),
+        0xfd6cf10du);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(0, data_chunk{ 0x00, 0x11 }),
+        0x16c6b7abu);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(0,
+        data_chunk{ 0x00, 0x11, 0x22 }), 0x8eb51c3du);
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__murmur3__blocks__expected)
+{
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(0,
+        data_chunk{ 0x00, 0x11, 0x22, 0x33 }), 0xb4471bf8u);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(0, element), 0xe2301fa8u);
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__contains__no_bytes__true)
+{
+    bloom_filter instance({}, 10, 0, bloom_filter::update_none);
+    instance.insert(element);
+    BOOST_REQUIRE(instance.contains(element));
+    BOOST_REQUIRE(instance.match(make_transaction(element)));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__contains__full__true)
+{
+    bloom_filter instance(data_chunk(64, 0xff), 10, 0,
+        bloom_filter::update_none);
+    BOOST_REQUIRE(instance.contains(element));
+    BOOST_REQUIRE(instance.match(make_transaction(element)));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__contains__empty__false)
+{
+    bloom_filter instance(data_chunk(64, 0x00), 10, 0,
+        bloom_filter::update_all);
+    BOOST_REQUIRE(!instance.contains(element));
+    BOOST_REQUIRE(!instance.match(make_transaction(element)));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__contains__inserted__true)
+{
+    bloom_filter instance(data_chunk(64, 0x00), 10, 42,
+        bloom_filter::update_none);
+    BOOST_REQUIRE(!instance.contains(element));
+    instance.insert(element);
+    BOOST_REQUIRE(instance.contains(element));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__match__unmatched__false)
+{
+    bloom_filter instance(data_chunk(64, 0x00), 10, 0,
+        bloom_filter::update_all);
+    BOOST_REQUIRE(!instance.match(make_transaction(element)));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__match__update_all__inserts_outpoint)
+{
+    const auto tx = make_transaction(element);
+    const auto outpoint = output_point{ tx.hash(), 0 }.to_data();
+    bloom_filter instance(data_chunk(64, 0x00), 10, 0,
+        bloom_filter::update_all);
+    instance.insert(element);
+    BOOST_REQUIRE(instance.match(tx));
+    BOOST_REQUIRE(instance.contains(outpoint));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__match__update_none__does_not_insert)
+{
+    const auto tx = make_transaction(element);
+    const auto outpoint = output_point{ tx.hash(), 0 }.to_data();
+    bloom_filter instance(data_chunk(64, 0x00), 10, 0,
+        bloom_filter::update_none);
+    instance.insert(element);
+    BOOST_REQUIRE(instance.match(tx));
+    BOOST_REQUIRE(!instance.contains(outpoint));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__match__unmasked_update_all__inserts_outpoint)
+{
+    const auto tx = make_transaction(element);
+    const auto outpoint = output_point{ tx.hash(), 0 }.to_data();
+    const uint8_t flags = 0x80 | bloom_filter::update_all;
+    bloom_filter instance(data_chunk(64, 0x00), 10, 0, flags);
+    instance.insert(element);
+    BOOST_REQUIRE(instance.match(tx));
+    BOOST_REQUIRE(instance.contains(outpoint));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,452 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+BOOST_AUTO_TEST_SUITE(chain_columns_tests)
+
+static chain::header make_header(uint32_t version, uint32_t timestamp,
+    uint32_t bits)
+{
+    return chain::header{ version, null_hash, null_hash, timestamp, bits, 0 };
+}
+
+// construct
+
+BOOST_AUTO_TEST_CASE(chain_columns__construct__default__empty)
+{
+    chain_columns instance;
+    size_t height;
+    BOOST_REQUIRE(instance.empty());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE(!instance.top(height));
+}
+
+// push
+
+BOOST_AUTO_TEST_CASE(chain_columns__push__one__round_trips)
+{
+    chain_columns instance;
+    const auto header = make_header(1, 2, 3);
+    instance.push(header, 4);
+
+    size_t height;
+    hash_digest hash;
+    uint32_t bits;
+    uint32_t timestamp;
+    uint32_t version;
+    uint8_t state;
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(instance.top(height));
+    BOOST_REQUIRE_EQUAL(height, 0u);
+    BOOST_REQUIRE(instance.get_block_hash(hash, 0));
+    BOOST_REQUIRE(hash == header.hash());
+    BOOST_REQUIRE(instance.get_version(version, 0));
+    BOOST_REQUIRE_EQUAL(version, 1u);
+    BOOST_REQUIRE(instance.get_timestamp(timestamp, 0));
+    BOOST_REQUIRE_EQUAL(timestamp, 2u);
+    BOOST_REQUIRE(instance.get_bits(bits, 0));
+    BOOST_REQUIRE_EQUAL(bits, 3u);
+    BOOST_REQUIRE(instance.get_state(state, 0));
+    BOOST_REQUIRE_EQUAL(state, 4u);
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__push__above_top__not_found)
+{
+    chain_columns instance;
+    instance.push(make_header(1, 2, 3), 4);
+
+    hash_digest hash;
+    uint32_t value;
+    uint8_t state;
+    BOOST_REQUIRE(!instance.get_block_hash(hash, 1));
+    BOOST_REQUIRE(!instance.get_bits(value, 1));
+    BOOST_REQUIRE(!instance.get_timestamp(value, 1));
+    BOOST_REQUIRE(!instance.get_version(value, 1));
+    BOOST_REQUIRE(!instance.get_median_time_past(value, 1));
+    BOOST_REQUIRE(!instance.get_state(state, 1));
+}
+
+// get_median_time_past
+
+BOOST_AUTO_TEST_CASE(chain_columns__get_median_time_past__genesis__zero)
+{
+    chain_columns instance;
+    instance.push(make_header(1, 42, 0), 0);
+
+    uint32_t time;
+    BOOST_REQUIRE(instance.get_median_time_past(time, 0));
+    BOOST_REQUIRE_EQUAL(time, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__get_median_time_past__twelve__median_of_previous_eleven)
+{
+    chain_columns instance;
+
+    // Timestamps descend, so the median of the previous 11 is the sixth.
+    for (uint32_t height = 0; height < 12; ++height)
+        instance.push(make_header(height, 100 - height, 0), 0);
+
+    uint32_t time;
+    BOOST_REQUIRE(instance.get_median_time_past(time, 11));
+    BOOST_REQUIRE_EQUAL(time, 95u);
+}
+
+// set_state
+
+BOOST_AUTO_TEST_CASE(chain_columns__set_state__existing__round_trips)
+{
+    chain_columns instance;
+    instance.push(make_header(1, 2, 3), 4);
+
+    uint8_t state;
+    BOOST_REQUIRE(instance.set_state(0, 5));
+    BOOST_REQUIRE(instance.get_state(state, 0));
+    BOOST_REQUIRE_EQUAL(state, 5u);
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__set_state__above_top__false)
+{
+    chain_columns instance;
+    instance.push(make_header(1, 2, 3), 4);
+    BOOST_REQUIRE(!instance.set_state(1, 5));
+}
+
+// get_schedule
+
+BOOST_AUTO_TEST_CASE(chain_columns__get_schedule__empty_and_populated__partitioned)
+{
+    chain_columns instance;
+    instance.push(make_header(1, 0, 0), 0);
+    instance.push(make_header(2, 0, 0), 0);
+    instance.push(make_header(3, 0, 0), 0);
+    BOOST_REQUIRE(instance.set_populated(1, true));
+
+    config::checkpoint::list empty;
+    config::checkpoint::list populated;
+    instance.get_schedule(empty, populated, 0, 42, 0, 0);
+    BOOST_REQUIRE_EQUAL(empty.size(), 2u);
+    BOOST_REQUIRE_EQUAL(empty[0].height(), 0u);
+    BOOST_REQUIRE_EQUAL(empty[1].height(), 2u);
+    BOOST_REQUIRE_EQUAL(populated.size(), 1u);
+    BOOST_REQUIRE_EQUAL(populated[0].height(), 1u);
+    BOOST_REQUIRE(populated[0].hash() == make_header(2, 0, 0).hash());
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__get_schedule__excluded_states__skipped)
+{
+    chain_columns instance;
+    instance.push(make_header(1, 0, 0), 1);
+    instance.push(make_header(2, 0, 0), 2);
+    instance.push(make_header(3, 0, 0), 0);
+    BOOST_REQUIRE(instance.set_populated(1, true));
+
+    config::checkpoint::list empty;
+    config::checkpoint::list populated;
+    instance.get_schedule(empty, populated, 0, 42, 1, 2);
+    BOOST_REQUIRE_EQUAL(empty.size(), 1u);
+    BOOST_REQUIRE_EQUAL(empty[0].height(), 2u);
+    BOOST_REQUIRE(populated.empty());
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__get_schedule__window__bounded)
+{
+    chain_columns instance;
+    instance.push(make_header(1, 0, 0), 0);
+    instance.push(make_header(2, 0, 0), 0);
+    instance.push(make_header(3, 0, 0), 0);
+
+    config::checkpoint::list empty;
+    config::checkpoint::list populated;
+    instance.get_schedule(empty, populated, 1, 1, 0, 0);
+    BOOST_REQUIRE_EQUAL(empty.size(), 1u);
+    BOOST_REQUIRE_EQUAL(empty[0].height(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__set_populated__above_top__false)
+{
+    chain_columns instance;
+    instance.push(make_header(1, 0, 0), 0);
+    BOOST_REQUIRE(!instance.set_populated(1, true));
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__truncate__populated__cleared)
+{
+    chain_columns instance;
+    instance.push(make_header(1, 0, 0), 0);
+    instance.push(make_header(2, 0, 0), 0);
+    BOOST_REQUIRE(instance.set_populated(1, true));
+    instance.truncate(1);
+    instance.push(make_header(3, 0, 0), 0);
+
+    config::checkpoint::list empty;
+    config::checkpoint::list populated;
+    instance.get_schedule(empty, populated, 0, 42, 0, 0);
+    BOOST_REQUIRE_EQUAL(empty.size(), 2u);
+    BOOST_REQUIRE(populated.empty());
+}
+
+// set_block
+
+BOOST_AUTO_TEST_CASE(chain_columns__set_block__matching_hash__set)
+{
+    chain_columns instance;
+    const auto header = make_header(1, 0, 0);
+    instance.push(header, 0);
+    BOOST_REQUIRE(instance.set_block(header.hash(), 0, 5, true));
+
+    uint8_t state;
+    BOOST_REQUIRE(instance.get_state(state, 0));
+    BOOST_REQUIRE_EQUAL(state, 5u);
+
+    config::checkpoint::list empty;
+    config::checkpoint::list populated;
+    instance.get_schedule(empty, populated, 0, 1, 0, 0);
+    BOOST_REQUIRE_EQUAL(populated.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__set_block__replaced_header__unchanged)
+{
+    chain_columns instance;
+    const auto header = make_header(1, 0, 0);
+    instance.push(header, 0);
+    instance.truncate(0);
+    instance.push(make_header(2, 0, 0), 3);
+    BOOST_REQUIRE(!instance.set_block(header.hash(), 0, 5, true));
+
+    uint8_t state;
+    BOOST_REQUIRE(instance.get_state(state, 0));
+    BOOST_REQUIRE_EQUAL(state, 3u);
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__set_block__above_top__false)
+{
+    chain_columns instance;
+    const auto header = make_header(1, 0, 0);
+    instance.push(header, 0);
+    BOOST_REQUIRE(!instance.set_block(header.hash(), 1, 5, true));
+}
+
+// truncate
+
+BOOST_AUTO_TEST_CASE(chain_columns__truncate__middle__top_below)
+{
+    chain_columns instance;
+    instance.push(make_header(1, 0, 0), 0);
+    instance.push(make_header(2, 0, 0), 0);
+    instance.push(make_header(3, 0, 0), 0);
+    instance.truncate(1);
+
+    size_t height;
+    uint32_t version;
+    BOOST_REQUIRE(instance.top(height));
+    BOOST_REQUIRE_EQUAL(height, 0u);
+    BOOST_REQUIRE(instance.get_version(version, 0));
+    BOOST_REQUIRE_EQUAL(version, 1u);
+    BOOST_REQUIRE(!instance.get_version(version, 1));
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__truncate__above_top__unchanged)
+{
+    chain_columns instance;
+    instance.push(make_header(1, 0, 0), 0);
+    instance.truncate(42);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__clear__populated__empty)
+{
+    chain_columns instance;
+    instance.push(make_header(1, 0, 0), 0);
+    instance.clear();
+    BOOST_REQUIRE(instance.empty());
+}
+
+// get_work
+
+BOOST_AUTO_TEST_CASE(chain_columns__get_work__empty__false)
+{
+    chain_columns instance;
+    uint256_t work;
+    BOOST_REQUIRE(!instance.get_work(work, 0));
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__get_work__above_top__zero)
+{
+    chain_columns instance;
+    instance.push(make_header(1, 0, 0x1d00ffff), 0);
+    instance.push(make_header(2, 0, 0x1d00ffff), 0);
+
+    uint256_t work;
+    BOOST_REQUIRE(instance.get_work(work, 1));
+    BOOST_REQUIRE(work == 0);
+    BOOST_REQUIRE(instance.get_work(work, 42));
+    BOOST_REQUIRE(work == 0);
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__get_work__above_genesis__sum_of_proofs_above)
+{
+    chain_columns instance;
+    const auto header0 = make_header(0, 0, 0x1d00ffff);
+    const auto header1 = make_header(1, 0, 0x1c00ffff);
+    const auto header2 = make_header(2, 0, 0x1b00ffff);
+    instance.push(header0, 0);
+    instance.push(header1, 0);
+    instance.push(header2, 0);
+
+    uint256_t work;
+    BOOST_REQUIRE(instance.get_work(work, 0));
+    BOOST_REQUIRE(work == header1.proof() + header2.proof());
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__get_work__truncated__excludes_removed)
+{
+    chain_columns instance;
+    const auto header0 = make_header(0, 0, 0x1d00ffff);
+    const auto header1 = make_header(1, 0, 0x1c00ffff);
+    instance.push(header0, 0);
+    instance.push(header1, 0);
+    instance.push(make_header(2, 0, 0x1b00ffff), 0);
+    instance.truncate(2);
+
+    uint256_t work;
+    BOOST_REQUIRE(instance.get_cumulative_work(work, 1));
+    BOOST_REQUIRE(work == header0.proof() + header1.proof());
+    BOOST_REQUIRE(instance.get_work(work, 0));
+    BOOST_REQUIRE(work == header1.proof());
+}
+
+// get_height
+
+BOOST_AUTO_TEST_CASE(chain_columns__get_height__cumulative_work__lowest_reaching_height)
+{
+    chain_columns instance;
+    const auto header0 = make_header(0, 0, 0x1d00ffff);
+    const auto header1 = make_header(1, 0, 0x1d00ffff);
+    const auto header2 = make_header(2, 0, 0x1d00ffff);
+    instance.push(header0, 0);
+    instance.push(header1, 0);
+    instance.push(header2, 0);
+
+    size_t height;
+    const auto work01 = header0.proof() + header1.proof();
+    BOOST_REQUIRE(instance.get_height(height, work01));
+    BOOST_REQUIRE_EQUAL(height, 1u);
+    BOOST_REQUIRE(instance.get_height(height, work01 + 1));
+    BOOST_REQUIRE_EQUAL(height, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__get_height__excess_work__false)
+{
+    chain_columns instance;
+    const auto header0 = make_header(0, 0, 0x1d00ffff);
+    instance.push(header0, 0);
+
+    size_t height;
+    BOOST_REQUIRE(!instance.get_height(height, header0.proof() + 1));
+}
+
+// find
+
+BOOST_AUTO_TEST_CASE(chain_columns__find__empty__false)
+{
+    chain_columns instance;
+    size_t height;
+    uint8_t state;
+    BOOST_REQUIRE(!instance.find(height, state, null_hash));
+    BOOST_REQUIRE(!instance.exists(null_hash));
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__find__pushed__height_and_state)
+{
+    chain_columns instance;
+    const auto header0 = make_header(0, 0, 0);
+    const auto header1 = make_header(1, 0, 0);
+    instance.push(header0, 4);
+    instance.push(header1, 5);
+
+    size_t height;
+    uint8_t state;
+    BOOST_REQUIRE(instance.find(height, state, header1.hash()));
+    BOOST_REQUIRE_EQUAL(height, 1u);
+    BOOST_REQUIRE_EQUAL(state, 5u);
+    BOOST_REQUIRE(instance.set_state(1, 6));
+    BOOST_REQUIRE(instance.find(height, state, header1.hash()));
+    BOOST_REQUIRE_EQUAL(state, 6u);
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__find__truncated__false)
+{
+    chain_columns instance;
+    const auto header0 = make_header(0, 0, 0);
+    const auto header1 = make_header(1, 0, 0);
+    instance.push(header0, 0);
+    instance.push(header1, 0);
+    instance.truncate(1);
+    BOOST_REQUIRE(instance.exists(header0.hash()));
+    BOOST_REQUIRE(!instance.exists(header1.hash()));
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__find__many_truncated__remaining_found)
+{
+    static const uint32_t count = 5000;
+    static const uint32_t retained = 3000;
+    chain_columns instance;
+
+    for (uint32_t height = 0; height < count; ++height)
+        instance.push(make_header(height, height, 0), 0);
+
+    instance.truncate(retained);
+
+    size_t height;
+    uint8_t state;
+
+    for (uint32_t index = 0; index < count; ++index)
+    {
+        const auto hash = make_header(index, index, 0).hash();
+        BOOST_REQUIRE_EQUAL(instance.find(height, state, hash), index < retained);
+
+        if (index < retained)
+            BOOST_REQUIRE_EQUAL(height, index);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(chain_columns__find__mostly_truncated__remaining_found)
+{
+    static const uint32_t count = 5000;
+    static const uint32_t retained = 600;
+    chain_columns instance;
+
+    for (uint32_t height = 0; height < count; ++height)
+        instance.push(make_header(height, height, 0), 0);
+
+    instance.truncate(retained);
+
+    for (uint32_t index = 0; index < count; ++index)
+    {
+        const auto hash = make_header(index, index, 0).hash();
+        BOOST_REQUIRE_EQUAL(instance.exists(hash), index < retained);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+BOOST_AUTO_TEST_SUITE(hash_filter_tests)
+
+static hash_digest make_hash(uint32_t id)
+{
+    return chain::header{ id, null_hash, null_hash, 0, 0, 0 }.hash();
+}
+
+// contains
+
+BOOST_AUTO_TEST_CASE(hash_filter__contains__zero_capacity__true)
+{
+    const hash_filter instance(0);
+    BOOST_REQUIRE(instance.contains(make_hash(1)));
+}
+
+BOOST_AUTO_TEST_CASE(hash_filter__contains__empty__false)
+{
+    const hash_filter instance(42);
+    BOOST_REQUIRE(!instance.contains(make_hash(1)));
+}
+
+BOOST_AUTO_TEST_CASE(hash_filter__contains__added__true)
+{
+    hash_filter instance(42);
+    const auto hash = make_hash(1);
+    instance.add(hash);
+    BOOST_REQUIRE(instance.contains(hash));
+}
+
+BOOST_AUTO_TEST_CASE(hash_filter__contains__over_capacity__all_added_true)
+{
+    hash_filter instance(100);
+
+    for (uint32_t id = 0; id < 1000; ++id)
+        instance.add(make_hash(id));
+
+    for (uint32_t id = 0; id < 1000; ++id)
+        BOOST_REQUIRE(instance.contains(make_hash(id)));
+}
+
+BOOST_AUTO_TEST_CASE(hash_filter__contains__not_added__mostly_false)
+{
+    hash_filter instance(1000);
+
+    for (uint32_t id = 0; id < 1000; ++id)
+        instance.add(make_hash(id));
+
+    size_t positives = 0;
+
+    for (uint32_t id = 1000; id < 2000; ++id)
+        if (instance.contains(make_hash(id)))
+            ++positives;
+
+    // The false positive rate at capacity is about one percent.
+    BOOST_REQUIRE_LT(positives, 50u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -231,6 +231,69 @@ BOOST_AUTO_TEST_CASE(header_branch__push_front__two_unlinked__link_failure)
     BOOST_REQUIRE((*instance.headers())[0] == header1);
 }
 
+// append
+
+BOOST_AUTO_TEST_CASE(header_branch__append__one__success)
+{
+    header_branch_fixture instance;
+    DECLARE_HEADER(header, 0);
+    BOOST_REQUIRE(instance.append(header0));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(instance.top() == header0);
+}
+
+BOOST_AUTO_TEST_CASE(header_branch__append__three_linked__success)
+{
+    header_branch_fixture instance;
+    DECLARE_HEADER(header, 0);
+    DECLARE_HEADER(header, 1);
+    DECLARE_HEADER(header, 2);
+
+    // Link the headers.
+    header1->set_previous_block_hash(header0->hash());
+    header2->set_previous_block_hash(header1->hash());
+
+    BOOST_REQUIRE(instance.append(header0));
+    BOOST_REQUIRE(instance.append(header1));
+    BOOST_REQUIRE(instance.append(header2));
+    BOOST_REQUIRE_EQUAL(instance.size(), 3u);
+    BOOST_REQUIRE((*instance.headers())[0] == header0);
+    BOOST_REQUIRE((*instance.headers())[1] == header1);
+    BOOST_REQUIRE((*instance.headers())[2] == header2);
+    BOOST_REQUIRE(instance.top() == header2);
+    BOOST_REQUIRE(instance.hash() == header0->previous_block_hash());
+}
+
+BOOST_AUTO_TEST_CASE(header_branch__append__after_push__success)
+{
+    header_branch_fixture instance;
+    DECLARE_HEADER(header, 0);
+    DECLARE_HEADER(header, 1);
+
+    // Link the headers.
+    header1->set_previous_block_hash(header0->hash());
+
+    BOOST_REQUIRE(instance.push(header0));
+    BOOST_REQUIRE(instance.append(header1));
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+    BOOST_REQUIRE(instance.top() == header1);
+}
+
+BOOST_AUTO_TEST_CASE(header_branch__append__unlinked__link_failure)
+{
+    header_branch_fixture instance;
+    DECLARE_HEADER(header, 0);
+    DECLARE_HEADER(header, 1);
+
+    // Ensure the headers are not linked.
+    header1->set_previous_block_hash(null_hash);
+
+    BOOST_REQUIRE(instance.append(header0));
+    BOOST_REQUIRE(!instance.append(header1));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(instance.top() == header0);
+}
+
 // top
 
 BOOST_AUTO_TEST_CASE(header_branch__top__default__nullptr)
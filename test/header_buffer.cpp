@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+BOOST_AUTO_TEST_SUITE(header_buffer_tests)
+
+static chain::header make_header(uint32_t id)
+{
+    return chain::header{ id, null_hash, null_hash, 0, 0, 0 };
+}
+
+// push
+
+BOOST_AUTO_TEST_CASE(header_buffer__push__two__size_two)
+{
+    header_buffer instance;
+    instance.push(make_header(1));
+    instance.push(make_header(2));
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+}
+
+// to_data
+
+BOOST_AUTO_TEST_CASE(header_buffer__to_data__empty__zero_count)
+{
+    header_buffer instance;
+    data_chunk data;
+    BOOST_REQUIRE_EQUAL(instance.to_data(data, 0, 10), 0u);
+    BOOST_REQUIRE_EQUAL(data.size(), 1u);
+    BOOST_REQUIRE_EQUAL(data[0], 0u);
+}
+
+BOOST_AUTO_TEST_CASE(header_buffer__to_data__range__expected)
+{
+    header_buffer instance;
+    const auto header1 = make_header(1);
+    const auto header2 = make_header(2);
+    instance.push(make_header(0));
+    instance.push(header1);
+    instance.push(header2);
+
+    data_chunk expected{ 0x02 };
+    const auto data1 = header1.to_data(true);
+    const auto data2 = header2.to_data(true);
+    expected.insert(expected.end(), data1.begin(), data1.end());
+    expected.push_back(0x00);
+    expected.insert(expected.end(), data2.begin(), data2.end());
+    expected.push_back(0x00);
+
+    data_chunk data;
+    BOOST_REQUIRE_EQUAL(instance.to_data(data, 1, 3), 2u);
+    BOOST_REQUIRE(data == expected);
+}
+
+BOOST_AUTO_TEST_CASE(header_buffer__to_data__end_above_size__limited)
+{
+    header_buffer instance;
+    instance.push(make_header(0));
+    instance.push(make_header(1));
+
+    data_chunk data;
+    BOOST_REQUIRE_EQUAL(instance.to_data(data, 1, 2000), 1u);
+    BOOST_REQUIRE_EQUAL(data.size(), 1u + header_buffer::record_size);
+}
+
+BOOST_AUTO_TEST_CASE(header_buffer__to_data__begin_above_end__zero_count)
+{
+    header_buffer instance;
+    instance.push(make_header(0));
+    instance.push(make_header(1));
+
+    data_chunk data;
+    BOOST_REQUIRE_EQUAL(instance.to_data(data, 2, 1), 0u);
+    BOOST_REQUIRE_EQUAL(data.size(), 1u);
+}
+
+// truncate
+
+BOOST_AUTO_TEST_CASE(header_buffer__truncate__middle__expected_size)
+{
+    header_buffer instance;
+    instance.push(make_header(0));
+    instance.push(make_header(1));
+    instance.push(make_header(2));
+    instance.truncate(1);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(header_buffer__truncate__above_size__unchanged)
+{
+    header_buffer instance;
+    instance.push(make_header(0));
+    instance.truncate(5);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+// clear
+
+BOOST_AUTO_TEST_CASE(header_buffer__clear__populated__empty)
+{
+    header_buffer instance;
+    instance.push(make_header(0));
+    instance.clear();
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
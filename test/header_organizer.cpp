@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <future>
+#include <memory>
+#include <bitcoin/blockchain.hpp>
+#include "utility.hpp"
+
+using namespace bc;
+using namespace bc::blockchain;
+using namespace bc::database;
+
+class header_organizer_setup_fixture
+{
+public:
+    header_organizer_setup_fixture()
+    {
+        log::initialize();
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(header_organizer_tests,
+    header_organizer_setup_fixture)
+
+static code organize_result(block_chain& instance,
+    headers_const_ptr headers)
+{
+    std::promise<code> promise;
+    const auto handler = [&promise](const code& ec)
+    {
+        promise.set_value(ec);
+    };
+
+    instance.organize(headers, handler);
+    return promise.get_future().get();
+}
+
+// organize
+
+BOOST_AUTO_TEST_CASE(header_organizer__organize__three_headers__all_candidates)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    const auto block1 = NEW_BLOCK(1);
+    const auto block2 = NEW_BLOCK(2);
+    const auto block3 = NEW_BLOCK(3);
+    const auto headers = std::make_shared<const message::headers>(
+        message::header::list
+        {
+            block1->header(), block2->header(), block3->header()
+        });
+
+    BOOST_REQUIRE(organize_result(instance, headers) == error::success);
+
+    size_t height;
+    BOOST_REQUIRE(instance.get_top_height(height, true));
+    BOOST_REQUIRE_EQUAL(height, 3u);
+    BOOST_REQUIRE(is_candidate(instance.get_block_state(block1->hash())));
+    BOOST_REQUIRE(is_candidate(instance.get_block_state(block2->hash())));
+    BOOST_REQUIRE(is_candidate(instance.get_block_state(block3->hash())));
+    BOOST_REQUIRE(instance.get_header(3, true)->hash() == block3->hash());
+}
+
+BOOST_AUTO_TEST_CASE(header_organizer__organize__overlapping_run__new_headers_candidates)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    const auto block1 = NEW_BLOCK(1);
+    const auto block2 = NEW_BLOCK(2);
+    const auto block3 = NEW_BLOCK(3);
+    const auto first = std::make_shared<const message::headers>(
+        message::header::list{ block1->header() });
+    const auto second = std::make_shared<const message::headers>(
+        message::header::list
+        {
+            block1->header(), block2->header(), block3->header()
+        });
+
+    BOOST_REQUIRE(organize_result(instance, first) == error::success);
+    BOOST_REQUIRE(organize_result(instance, second) == error::success);
+
+    size_t height;
+    BOOST_REQUIRE(instance.get_top_height(height, true));
+    BOOST_REQUIRE_EQUAL(height, 3u);
+    BOOST_REQUIRE(is_candidate(instance.get_block_state(block2->hash())));
+    BOOST_REQUIRE(is_candidate(instance.get_block_state(block3->hash())));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+BOOST_AUTO_TEST_SUITE(partial_merkle_tree_tests)
+
+static const hash_digest hash_a{ { 0x0a } };
+static const hash_digest hash_b{ { 0x0b } };
+static const hash_digest hash_c{ { 0x0c } };
+static const hash_digest hash_d{ { 0x0d } };
+
+static hash_digest parent(const hash_digest& left, const hash_digest& right)
+{
+    return bitcoin_hash(build_chunk({ left, right }));
+}
+
+BOOST_AUTO_TEST_CASE(partial_merkle_tree__construct__mismatched_matches__empty)
+{
+    const partial_merkle_tree instance({ hash_a, hash_b }, { true });
+    BOOST_REQUIRE(instance.hashes().empty());
+    BOOST_REQUIRE(instance.flags().empty());
+}
+
+BOOST_AUTO_TEST_CASE(partial_merkle_tree__construct__single_matched__leaf)
+{
+    const partial_merkle_tree instance({ hash_a }, { true });
+    BOOST_REQUIRE(instance.hashes() == hash_list{ hash_a });
+    BOOST_REQUIRE(instance.flags() == data_chunk{ 0x01 });
+}
+
+BOOST_AUTO_TEST_CASE(partial_merkle_tree__construct__none_matched__root)
+{
+    const auto root = parent(parent(hash_a, hash_b), parent(hash_c, hash_d));
+    const partial_merkle_tree instance({ hash_a, hash_b, hash_c, hash_d },
+        { false, false, false, false });
+    BOOST_REQUIRE(instance.hashes() == hash_list{ root });
+    BOOST_REQUIRE(instance.flags() == data_chunk{ 0x00 });
+}
+
+BOOST_AUTO_TEST_CASE(partial_merkle_tree__construct__third_matched__pruned)
+{
+    const partial_merkle_tree instance({ hash_a, hash_b, hash_c, hash_d },
+        { false, false, true, false });
+    const hash_list expected{ parent(hash_a, hash_b), hash_c, hash_d };
+    BOOST_REQUIRE(instance.hashes() == expected);
+
+    // Walk flags 1, 0, 1, 1, 0 from the low bit.
+    BOOST_REQUIRE(instance.flags() == data_chunk{ 0x0d });
+}
+
+BOOST_AUTO_TEST_CASE(partial_merkle_tree__construct__odd_matched__not_repeated)
+{
+    const partial_merkle_tree instance({ hash_a, hash_b, hash_c },
+        { false, false, true });
+    const hash_list expected{ parent(hash_a, hash_b), hash_c };
+    BOOST_REQUIRE(instance.hashes() == expected);
+
+    // Walk flags 1, 0, 1, 1 from the low bit.
+    BOOST_REQUIRE(instance.flags() == data_chunk{ 0x0d });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,168 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <future>
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+BOOST_AUTO_TEST_SUITE(query_executor_tests)
+
+// execute
+
+BOOST_AUTO_TEST_CASE(query_executor__execute__no_threads__executed_inline)
+{
+    threadpool pool(0);
+    query_executor instance(pool, { { 1, 1 } });
+    auto executed = false;
+    BOOST_REQUIRE(instance.execute(0, [&]() { executed = true; }));
+    BOOST_REQUIRE(executed);
+}
+
+BOOST_AUTO_TEST_CASE(query_executor__execute__at_limits__queued_then_rejected)
+{
+    threadpool pool(2);
+    query_executor instance(pool, { { 1, 1 } });
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::promise<void> started;
+    std::promise<void> completed;
+    std::atomic<size_t> count(0);
+
+    BOOST_REQUIRE(instance.execute(0, [&]()
+    {
+        started.set_value();
+        released.wait();
+        ++count;
+    }));
+
+    started.get_future().wait();
+
+    BOOST_REQUIRE(instance.execute(0, [&]()
+    {
+        ++count;
+        completed.set_value();
+    }));
+
+    BOOST_REQUIRE_EQUAL(instance.pending(0), 1u);
+    BOOST_REQUIRE(!instance.execute(0, [&]() { ++count; }));
+
+    release.set_value();
+    completed.get_future().wait();
+    BOOST_REQUIRE_EQUAL(count.load(), 2u);
+    BOOST_REQUIRE_EQUAL(instance.pending(0), 0u);
+
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(query_executor__execute__other_class_at_limit__executed)
+{
+    threadpool pool(2);
+    query_executor instance(pool, { { 1, 0 }, { 1, 0 } });
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::promise<void> started;
+    std::promise<void> completed;
+
+    BOOST_REQUIRE(instance.execute(0, [&]()
+    {
+        started.set_value();
+        released.wait();
+    }));
+
+    started.get_future().wait();
+    BOOST_REQUIRE(!instance.execute(0, []() {}));
+    BOOST_REQUIRE(instance.execute(1, [&]() { completed.set_value(); }));
+    completed.get_future().wait();
+
+    release.set_value();
+    pool.shutdown();
+    pool.join();
+}
+
+// stop
+
+BOOST_AUTO_TEST_CASE(query_executor__stop__execute__rejected)
+{
+    threadpool pool(1);
+    query_executor instance(pool, { { 1, 1 } });
+    BOOST_REQUIRE(instance.stop());
+    BOOST_REQUIRE(!instance.execute(0, []() {}));
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(query_executor__stop__from_query__not_waited)
+{
+    threadpool pool(1);
+    query_executor instance(pool, { { 1, 1 } });
+    std::promise<bool> stopped;
+
+    BOOST_REQUIRE(instance.execute(0, [&]()
+    {
+        stopped.set_value(instance.stop());
+    }));
+
+    BOOST_REQUIRE(!stopped.get_future().get());
+    BOOST_REQUIRE(instance.stop());
+    BOOST_REQUIRE(!instance.execute(0, []() {}));
+
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(query_executor__stop__queued__executed_before_return)
+{
+    threadpool pool(1);
+    query_executor instance(pool, { { 1, 2 } });
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::promise<void> started;
+    std::atomic<size_t> count(0);
+
+    BOOST_REQUIRE(instance.execute(0, [&]()
+    {
+        started.set_value();
+        released.wait();
+        ++count;
+    }));
+
+    started.get_future().wait();
+    BOOST_REQUIRE(instance.execute(0, [&]() { ++count; }));
+    BOOST_REQUIRE(instance.execute(0, [&]() { ++count; }));
+
+    auto stopped = std::async(std::launch::async, [&]()
+    {
+        return instance.stop();
+    });
+
+    release.set_value();
+    BOOST_REQUIRE(stopped.get());
+    BOOST_REQUIRE_EQUAL(count.load(), 3u);
+    BOOST_REQUIRE(!instance.execute(0, []() {}));
+
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,236 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <boost/filesystem.hpp>
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+#define TEST_NAME \
+    std::string(boost::unit_test::framework::current_test_case().p_name)
+
+// Few buckets, for more collision.
+#define OPEN_INDEX(name) \
+    spend_index name(TEST_NAME, 3); \
+    BOOST_REQUIRE(name.open()); \
+    BOOST_REQUIRE(name.clear())
+
+BOOST_AUTO_TEST_SUITE(spend_index_tests)
+
+static const hash_digest hash1
+{
+    {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10,
+        0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+        0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20
+    }
+};
+
+// get
+
+BOOST_AUTO_TEST_CASE(spend_index__get__empty__empty)
+{
+    OPEN_INDEX(instance);
+    spend_index::spender::list spenders;
+    instance.get(spenders, chain::output_point{ hash1, 0 });
+    BOOST_REQUIRE(spenders.empty());
+}
+
+BOOST_AUTO_TEST_CASE(spend_index__get__added__expected)
+{
+    OPEN_INDEX(instance);
+    const chain::output_point outpoint{ hash1, 1 };
+    instance.add(outpoint, { 42, 7, 3 });
+
+    spend_index::spender::list spenders;
+    instance.get(spenders, outpoint);
+    BOOST_REQUIRE_EQUAL(spenders.size(), 1u);
+    BOOST_REQUIRE_EQUAL(spenders[0].height, 42u);
+    BOOST_REQUIRE_EQUAL(spenders[0].position, 7u);
+    BOOST_REQUIRE_EQUAL(spenders[0].input, 3u);
+}
+
+BOOST_AUTO_TEST_CASE(spend_index__get__other_index__empty)
+{
+    OPEN_INDEX(instance);
+    instance.add(chain::output_point{ hash1, 1 }, { 42, 7, 3 });
+
+    spend_index::spender::list spenders;
+    instance.get(spenders, chain::output_point{ hash1, 2 });
+    BOOST_REQUIRE(spenders.empty());
+}
+
+// remove
+
+BOOST_AUTO_TEST_CASE(spend_index__remove__above_height__removed)
+{
+    OPEN_INDEX(instance);
+    const chain::output_point outpoint{ hash1, 1 };
+    instance.add(outpoint, { 42, 7, 3 });
+    instance.remove(outpoint, 41);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(spend_index__remove__at_height__retained)
+{
+    OPEN_INDEX(instance);
+    const chain::output_point outpoint{ hash1, 1 };
+    instance.add(outpoint, { 42, 7, 3 });
+    instance.remove(outpoint, 42);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(spend_index__remove__two_spenders__lower_retained)
+{
+    OPEN_INDEX(instance);
+    const chain::output_point outpoint{ hash1, 1 };
+    instance.add(outpoint, { 10, 1, 0 });
+    instance.add(outpoint, { 20, 2, 0 });
+    instance.remove(outpoint, 15);
+
+    spend_index::spender::list spenders;
+    instance.get(spenders, outpoint);
+    BOOST_REQUIRE_EQUAL(spenders.size(), 1u);
+    BOOST_REQUIRE_EQUAL(spenders[0].height, 10u);
+}
+
+BOOST_AUTO_TEST_CASE(spend_index__remove__colliding_other_outpoint__retained)
+{
+    OPEN_INDEX(instance);
+    const chain::output_point outpoint1{ hash1, 1 };
+    const chain::output_point outpoint2{ hash1, 2 };
+    instance.add(outpoint1, { 10, 1, 0 });
+    instance.add(outpoint2, { 20, 2, 0 });
+    instance.add(outpoint1, { 30, 3, 0 });
+    instance.remove(outpoint1, 0);
+
+    spend_index::spender::list spenders;
+    instance.get(spenders, outpoint2);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE_EQUAL(spenders.size(), 1u);
+    BOOST_REQUIRE_EQUAL(spenders[0].height, 20u);
+}
+
+// height
+
+BOOST_AUTO_TEST_CASE(spend_index__height__created__uncommitted)
+{
+    OPEN_INDEX(instance);
+    BOOST_REQUIRE_EQUAL(instance.height(), max_size_t);
+}
+
+BOOST_AUTO_TEST_CASE(spend_index__height__set_height__expected)
+{
+    OPEN_INDEX(instance);
+    BOOST_REQUIRE(instance.begin_write());
+    instance.set_height(42);
+    BOOST_REQUIRE_EQUAL(instance.height(), 42u);
+}
+
+BOOST_AUTO_TEST_CASE(spend_index__height__end_write__expected)
+{
+    OPEN_INDEX(instance);
+    BOOST_REQUIRE(instance.begin_write());
+    BOOST_REQUIRE(instance.end_write(42));
+    BOOST_REQUIRE_EQUAL(instance.height(), 42u);
+}
+
+// open
+
+BOOST_AUTO_TEST_CASE(spend_index__open__committed__persisted)
+{
+    const chain::output_point outpoint{ hash1, 1 };
+
+    {
+        OPEN_INDEX(instance);
+        BOOST_REQUIRE(instance.begin_write());
+        instance.add(outpoint, { 42, 7, 3 });
+        BOOST_REQUIRE(instance.end_write(42));
+        BOOST_REQUIRE(instance.close());
+    }
+
+    spend_index instance(TEST_NAME, 3);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE_EQUAL(instance.height(), 42u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    spend_index::spender::list spenders;
+    instance.get(spenders, outpoint);
+    BOOST_REQUIRE_EQUAL(spenders.size(), 1u);
+    BOOST_REQUIRE_EQUAL(spenders[0].position, 7u);
+}
+
+BOOST_AUTO_TEST_CASE(spend_index__open__uncommitted__uncommitted)
+{
+    {
+        OPEN_INDEX(instance);
+        BOOST_REQUIRE(instance.end_write(42));
+        BOOST_REQUIRE(instance.begin_write());
+        instance.add(chain::output_point{ hash1, 1 }, { 43, 7, 3 });
+    }
+
+    spend_index instance(TEST_NAME, 3);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE_EQUAL(instance.height(), max_size_t);
+}
+
+BOOST_AUTO_TEST_CASE(spend_index__open__set_height_closed__committed)
+{
+    {
+        OPEN_INDEX(instance);
+        BOOST_REQUIRE(instance.begin_write());
+        instance.set_height(42);
+        BOOST_REQUIRE(instance.close());
+    }
+
+    spend_index instance(TEST_NAME, 3);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE_EQUAL(instance.height(), 42u);
+}
+
+BOOST_AUTO_TEST_CASE(spend_index__open__other_buckets__recreated)
+{
+    {
+        OPEN_INDEX(instance);
+        instance.add(chain::output_point{ hash1, 1 }, { 42, 7, 3 });
+        BOOST_REQUIRE(instance.end_write(42));
+        BOOST_REQUIRE(instance.close());
+    }
+
+    spend_index instance(TEST_NAME, 5);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE_EQUAL(instance.height(), max_size_t);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+// clear
+
+BOOST_AUTO_TEST_CASE(spend_index__clear__populated__empty)
+{
+    OPEN_INDEX(instance);
+    instance.add(chain::output_point{ hash1, 1 }, { 42, 7, 3 });
+    BOOST_REQUIRE(instance.clear());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,235 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+#define TEST_NAME \
+    std::string(boost::unit_test::framework::current_test_case().p_name)
+
+#define OPEN_INDEX(name) \
+    stealth_index name(TEST_NAME); \
+    BOOST_REQUIRE(name.open()); \
+    BOOST_REQUIRE(name.clear())
+
+BOOST_AUTO_TEST_SUITE(stealth_index_tests)
+
+static stealth_index::record make_record(uint32_t prefix, size_t height)
+{
+    return { prefix, height, null_hash, {}, null_hash };
+}
+
+// Serialized prefix bytes (little endian) are 0xba, 0xdc, 0xfe, 0x00.
+static const uint32_t prefix1 = 0x00fedcba;
+static const hash_digest key1{ { 0x01 } };
+
+// scan
+
+BOOST_AUTO_TEST_CASE(stealth_index__scan__empty_filter__all)
+{
+    OPEN_INDEX(instance);
+    instance.add(make_record(prefix1, 1));
+    instance.add(make_record(42, 2));
+
+    stealth_index::record::list records;
+    instance.scan(records, binary{}, 0);
+    BOOST_REQUIRE_EQUAL(records.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(stealth_index__scan__matching_filter__expected)
+{
+    OPEN_INDEX(instance);
+    instance.add(make_record(prefix1, 1));
+    instance.add(make_record(42, 2));
+
+    // The first twelve bits of 0xba, 0xdc.
+    stealth_index::record::list records;
+    instance.scan(records, binary{ 12, data_chunk{ 0xba, 0xd0 } }, 0);
+    BOOST_REQUIRE_EQUAL(records.size(), 1u);
+    BOOST_REQUIRE_EQUAL(records[0].prefix, prefix1);
+    BOOST_REQUIRE_EQUAL(records[0].height, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(stealth_index__scan__mismatched_filter__empty)
+{
+    OPEN_INDEX(instance);
+    instance.add(make_record(prefix1, 1));
+
+    stealth_index::record::list records;
+    instance.scan(records, binary{ 12, data_chunk{ 0xba, 0xe0 } }, 0);
+    BOOST_REQUIRE(records.empty());
+}
+
+BOOST_AUTO_TEST_CASE(stealth_index__scan__over_32_bits__empty)
+{
+    OPEN_INDEX(instance);
+    instance.add(make_record(prefix1, 1));
+
+    const data_chunk blocks{ 0xba, 0xdc, 0xfe, 0x00, 0x00 };
+    stealth_index::record::list records;
+    instance.scan(records, binary{ 33, blocks }, 0);
+    BOOST_REQUIRE(records.empty());
+}
+
+BOOST_AUTO_TEST_CASE(stealth_index__scan__from_height__excludes_lower)
+{
+    OPEN_INDEX(instance);
+    instance.add(make_record(prefix1, 1));
+    instance.add(make_record(prefix1, 5));
+
+    stealth_index::record::list records;
+    instance.scan(records, binary{}, 3);
+    BOOST_REQUIRE_EQUAL(records.size(), 1u);
+    BOOST_REQUIRE_EQUAL(records[0].height, 5u);
+}
+
+BOOST_AUTO_TEST_CASE(stealth_index__scan__many_runs__all_matches)
+{
+    OPEN_INDEX(instance);
+
+    for (size_t height = 0; height < 200; ++height)
+        instance.add(make_record(height % 2 == 0 ? prefix1 : 42, height));
+
+    stealth_index::record::list records;
+    instance.scan(records, binary{ 8, data_chunk{ 0xba } }, 0);
+    BOOST_REQUIRE_EQUAL(records.size(), 100u);
+    BOOST_REQUIRE_EQUAL(records.back().height, 198u);
+}
+
+// remove
+
+BOOST_AUTO_TEST_CASE(stealth_index__remove__above_height__removed)
+{
+    OPEN_INDEX(instance);
+    instance.add(make_record(prefix1, 1));
+    instance.add(make_record(prefix1, 2));
+    instance.add(make_record(prefix1, 3));
+    instance.set_top(3);
+    instance.remove(1);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.top(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(stealth_index__remove__above_top__top_unchanged)
+{
+    OPEN_INDEX(instance);
+    instance.add(make_record(prefix1, 1));
+    instance.set_top(1);
+    instance.remove(5);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.top(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(stealth_index__scan__from_height_between_runs__expected)
+{
+    OPEN_INDEX(instance);
+
+    for (size_t height = 0; height < 200; ++height)
+        instance.add(make_record(prefix1, height));
+
+    stealth_index::record::list records;
+    instance.scan(records, binary{}, 100);
+    BOOST_REQUIRE_EQUAL(records.size(), 100u);
+    BOOST_REQUIRE_EQUAL(records.front().height, 100u);
+}
+
+// top
+
+BOOST_AUTO_TEST_CASE(stealth_index__top__default__max_size_t)
+{
+    OPEN_INDEX(instance);
+    BOOST_REQUIRE_EQUAL(instance.top(), max_size_t);
+}
+
+// clear
+
+BOOST_AUTO_TEST_CASE(stealth_index__clear__populated__empty)
+{
+    OPEN_INDEX(instance);
+    instance.add(make_record(prefix1, 1));
+    instance.set_top(1);
+    BOOST_REQUIRE(instance.clear());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.top(), max_size_t);
+}
+
+// open
+
+BOOST_AUTO_TEST_CASE(stealth_index__open__committed__persisted)
+{
+    {
+        OPEN_INDEX(instance);
+        BOOST_REQUIRE(instance.begin_write());
+        instance.add({ prefix1, 1, key1, {}, null_hash });
+        instance.add(make_record(42, 2));
+        BOOST_REQUIRE(instance.end_write(2));
+        BOOST_REQUIRE(instance.close());
+    }
+
+    stealth_index instance(TEST_NAME);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE_EQUAL(instance.top(), 2u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+
+    stealth_index::record::list records;
+    instance.scan(records, binary{}, 0);
+    BOOST_REQUIRE_EQUAL(records.size(), 2u);
+    BOOST_REQUIRE_EQUAL(records[0].prefix, prefix1);
+    BOOST_REQUIRE(records[0].ephemeral_key != null_hash);
+    BOOST_REQUIRE_EQUAL(records[1].height, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(stealth_index__open__popped_and_committed__popped)
+{
+    {
+        OPEN_INDEX(instance);
+        instance.add(make_record(prefix1, 1));
+        instance.add(make_record(prefix1, 2));
+        BOOST_REQUIRE(instance.end_write(2));
+        BOOST_REQUIRE(instance.begin_write());
+        instance.remove(1);
+        BOOST_REQUIRE(instance.end_write(1));
+        BOOST_REQUIRE(instance.close());
+    }
+
+    stealth_index instance(TEST_NAME);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE_EQUAL(instance.top(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(stealth_index__open__uncommitted__max_size_t)
+{
+    {
+        OPEN_INDEX(instance);
+        BOOST_REQUIRE(instance.end_write(1));
+        BOOST_REQUIRE(instance.begin_write());
+        instance.add(make_record(prefix1, 2));
+    }
+
+    stealth_index instance(TEST_NAME);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE_EQUAL(instance.top(), max_size_t);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,182 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+BOOST_AUTO_TEST_SUITE(transaction_cache_tests)
+
+static transaction_const_ptr make_transaction(uint32_t id)
+{
+    return std::make_shared<const message::transaction>(
+        chain::transaction{ id, 0, {}, {} });
+}
+
+// add
+
+BOOST_AUTO_TEST_CASE(transaction_cache__add__zero_capacity__empty)
+{
+    transaction_cache instance(0);
+    instance.add(make_transaction(1), 0, 0);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_cache__add__twice__single)
+{
+    transaction_cache instance(42);
+    const auto tx = make_transaction(1);
+    instance.add(tx, 0, 0);
+    instance.add(tx, 0, 0);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_cache__add__same_hash__replaced)
+{
+    transaction_cache instance(42);
+    const auto tx1 = make_transaction(1);
+    const auto tx2 = make_transaction(1);
+    instance.add(tx1, 1, 2);
+    instance.add(tx2, 3, 4);
+
+    transaction_const_ptr out_tx;
+    size_t out_position;
+    size_t out_height;
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(instance.get(out_tx, out_position, out_height, tx1->hash()));
+    BOOST_REQUIRE(out_tx == tx2);
+    BOOST_REQUIRE_EQUAL(out_position, 3u);
+    BOOST_REQUIRE_EQUAL(out_height, 4u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_cache__add__over_capacity__bounded)
+{
+    // Each of the sixteen shards holds one transaction.
+    transaction_cache instance(16);
+
+    for (uint32_t id = 0; id < 100; ++id)
+        instance.add(make_transaction(id), 0, 0);
+
+    BOOST_REQUIRE(instance.size() <= 16u);
+    BOOST_REQUIRE(instance.size() > 0u);
+}
+
+// get
+
+BOOST_AUTO_TEST_CASE(transaction_cache__get__missing__false_miss)
+{
+    transaction_cache instance(42);
+    transaction_const_ptr out_tx;
+    size_t out_position;
+    size_t out_height;
+    BOOST_REQUIRE(!instance.get(out_tx, out_position, out_height, null_hash));
+    BOOST_REQUIRE_EQUAL(instance.hits(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.misses(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_cache__get__existing__expected_hit)
+{
+    transaction_cache instance(42);
+    const auto tx = make_transaction(1);
+    instance.add(tx, 5, 6);
+
+    transaction_const_ptr out_tx;
+    size_t out_position;
+    size_t out_height;
+    BOOST_REQUIRE(instance.get(out_tx, out_position, out_height, tx->hash()));
+    BOOST_REQUIRE(out_tx == tx);
+    BOOST_REQUIRE_EQUAL(out_position, 5u);
+    BOOST_REQUIRE_EQUAL(out_height, 6u);
+    BOOST_REQUIRE_EQUAL(instance.hits(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.misses(), 0u);
+}
+
+// exists
+
+BOOST_AUTO_TEST_CASE(transaction_cache__exists__missing__false)
+{
+    const transaction_cache instance(42);
+    BOOST_REQUIRE(!instance.exists(null_hash));
+    BOOST_REQUIRE_EQUAL(instance.misses(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_cache__exists__existing__true_not_counted)
+{
+    transaction_cache instance(42);
+    const auto tx = make_transaction(1);
+    instance.add(tx, 5, 6);
+    BOOST_REQUIRE(instance.exists(tx->hash()));
+    BOOST_REQUIRE_EQUAL(instance.hits(), 0u);
+}
+
+// confirm
+
+BOOST_AUTO_TEST_CASE(transaction_cache__confirm__existing__updated)
+{
+    transaction_cache instance(42);
+    const auto tx = make_transaction(1);
+    instance.add(tx, 0, 0);
+    instance.confirm(tx->hash(), 7, 8);
+
+    transaction_const_ptr out_tx;
+    size_t out_position;
+    size_t out_height;
+    BOOST_REQUIRE(instance.get(out_tx, out_position, out_height, tx->hash()));
+    BOOST_REQUIRE_EQUAL(out_position, 7u);
+    BOOST_REQUIRE_EQUAL(out_height, 8u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_cache__confirm__missing__not_added)
+{
+    transaction_cache instance(42);
+    instance.confirm(null_hash, 7, 8);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+// remove
+
+BOOST_AUTO_TEST_CASE(transaction_cache__remove__existing__removed)
+{
+    transaction_cache instance(42);
+    const auto tx = make_transaction(1);
+    instance.add(tx, 0, 0);
+    instance.remove(tx->hash());
+
+    transaction_const_ptr out_tx;
+    size_t out_position;
+    size_t out_height;
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE(!instance.get(out_tx, out_position, out_height, tx->hash()));
+}
+
+// clear
+
+BOOST_AUTO_TEST_CASE(transaction_cache__clear__populated__empty)
+{
+    transaction_cache instance(42);
+    instance.add(make_transaction(1), 0, 0);
+    instance.add(make_transaction(2), 0, 0);
+    instance.clear();
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+BOOST_AUTO_TEST_SUITE(write_batch_tests)
+
+BOOST_AUTO_TEST_CASE(write_batch__add__disabled__complete)
+{
+    write_batch instance(0, 0);
+    BOOST_REQUIRE(!instance.enabled());
+    BOOST_REQUIRE(!instance.begin());
+    BOOST_REQUIRE(instance.add(1, 42));
+}
+
+BOOST_AUTO_TEST_CASE(write_batch__add__block_limit__complete_and_reset)
+{
+    write_batch instance(3, 0);
+    BOOST_REQUIRE(instance.enabled());
+    BOOST_REQUIRE(!instance.add(1, 1));
+    BOOST_REQUIRE(!instance.add(1, 1));
+    BOOST_REQUIRE(instance.add(1, 1));
+    BOOST_REQUIRE(!instance.add(1, 1));
+}
+
+BOOST_AUTO_TEST_CASE(write_batch__add__multiple_blocks__counted)
+{
+    write_batch instance(3, 0);
+    BOOST_REQUIRE(!instance.add(2, 1));
+    BOOST_REQUIRE(instance.add(2, 1));
+}
+
+BOOST_AUTO_TEST_CASE(write_batch__add__no_blocks__not_counted)
+{
+    write_batch instance(2, 0);
+    BOOST_REQUIRE(!instance.add(1, 1));
+    BOOST_REQUIRE(!instance.add(0, 0));
+    BOOST_REQUIRE(!instance.add(0, 0));
+    BOOST_REQUIRE(instance.add(1, 1));
+}
+
+BOOST_AUTO_TEST_CASE(write_batch__add__byte_limit__complete)
+{
+    write_batch instance(100, 50);
+    BOOST_REQUIRE(!instance.add(1, 20));
+    BOOST_REQUIRE(!instance.add(0, 20));
+    BOOST_REQUIRE(instance.add(1, 20));
+}
+
+BOOST_AUTO_TEST_CASE(write_batch__begin__open__false)
+{
+    write_batch instance(100, 0);
+    BOOST_REQUIRE(instance.begin());
+    BOOST_REQUIRE(!instance.begin());
+    BOOST_REQUIRE(instance.reset());
+    BOOST_REQUIRE(instance.begin());
+}
+
+BOOST_AUTO_TEST_CASE(write_batch__begin__completed__true)
+{
+    write_batch instance(1, 0);
+    BOOST_REQUIRE(instance.begin());
+    BOOST_REQUIRE(instance.add(1, 1));
+    BOOST_REQUIRE(instance.begin());
+}
+
+BOOST_AUTO_TEST_CASE(write_batch__reset__pending__true_then_false)
+{
+    write_batch instance(100, 0);
+    BOOST_REQUIRE(!instance.reset());
+    BOOST_REQUIRE(!instance.add(1, 1));
+    BOOST_REQUIRE(instance.reset());
+    BOOST_REQUIRE(!instance.reset());
+}
+
+BOOST_AUTO_TEST_SUITE_END()